@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 #include "ChessErrorHandler.h"
 #include "ChessGameMove.h"
 #include "ChessGame.h"
@@ -47,6 +48,15 @@ static const char PRINT_GAME_WHITESPACE = ' ';
  */
 static const int HISTORY_SIZE = 6;
 
+/**
+ * Zobrist keys for hashing positions. A position's hash is the xor of the keys
+ * of each piece in its square, and the white player key if it's white's turn.
+ */
+#define ZOBRIST_SEED 1070372ULL
+static bool zobristInitialized = false;
+static uint64_t zobristPieces[CHESS_N_PLAYERS][CHESS_N_PIECE_TYPES][CHESS_N_SQUARES];
+static uint64_t zobristWhitePlayer;
+
 /**
  * Declaration of chess pieces. These are constants.
  */
@@ -90,9 +100,69 @@ CHESS_NON_PLAYER, .representation = EMPTY_ENTRY_SYMBOL };
  */
 static bool isKingThreatened(ChessGame* game, int player);
 
+/**
+ * Fills the Zobrist keys, the same keys are generated on each run.
+ */
+static void initZobristKeys() {
+	uint64_t seed = ZOBRIST_SEED;
+	if (zobristInitialized)
+		return;
+	for (int player = 0; player < CHESS_N_PLAYERS; player++)
+		for (int type = 0; type < CHESS_N_PIECE_TYPES; type++)
+			for (int square = 0; square < CHESS_N_SQUARES; square++)
+				zobristPieces[player][type][square] = chessGameNextRandom(
+						&seed);
+	zobristWhitePlayer = chessGameNextRandom(&seed);
+	zobristInitialized = true;
+}
+
+/**
+ * Gets the Zobrist key of the piece in the given position, 0 if empty.
+ */
+static uint64_t getPieceKey(ChessPiece piece, ChessPiecePosition pos) {
+	if (piece.type == CHESS_PIECE_EMPTY)
+		return 0;
+	return zobristPieces[piece.player][piece.type][chessGamePositionToSquare(
+			pos)];
+}
+
+/**
+ * Computes the hash of the game's position from scratch.
+ */
+static uint64_t computeHash(ChessGame* game) {
+	uint64_t hash =
+			game->currentPlayer == CHESS_WHITE_PLAYER ? zobristWhitePlayer : 0;
+	for (int player = 0; player < CHESS_N_PLAYERS; player++)
+		for (int type = 0; type < CHESS_N_PIECE_TYPES; type++) {
+			ChessBitboard pieces = game->gameBoard.pieces[player][type];
+			while (pieces)
+				hash ^= zobristPieces[player][type][chessBitboardPopFirstSquare(
+						&pieces)];
+		}
+	return hash;
+}
+
+/**
+ * Computes the evaluation of the game's position from scratch.
+ */
+static ChessEvaluation computeEvaluation(ChessGame* game) {
+	ChessEvaluation eval = chessEvalCreate();
+	for (int player = 0; player < CHESS_N_PLAYERS; player++)
+		for (int type = 0; type < CHESS_N_PIECE_TYPES; type++) {
+			ChessPiece piece = { .type = (CHESS_PIECE_TYPE) type, .player =
+					player };
+			ChessBitboard pieces = game->gameBoard.pieces[player][type];
+			while (pieces)
+				chessEvalAddPiece(&eval, piece,
+						chessBitboardPopFirstSquare(&pieces));
+		}
+	return eval;
+}
+
 /**
  * Sets the the given piece in the given position of the game's board.
- * Updates king position field if piece is king.
+ * Updates king position field if piece is king, the game's hash and its
+ * evaluation.
  */
 static void setPieceInPosition(ChessGame* game, ChessPiecePosition pos,
 		ChessPiece piece) {
@@ -102,7 +172,12 @@ static void setPieceInPosition(ChessGame* game, ChessPiecePosition pos,
 		else
 			game->blackKingPosition = pos;
 	}
-	game->gameBoard.position[pos.row][pos.column] = piece;
+	ChessPiece prevPiece = chessGameGetPieceByPosition(&(game->gameBoard), pos);
+	int square = chessGamePositionToSquare(pos);
+	game->hash ^= getPieceKey(prevPiece, pos) ^ getPieceKey(piece, pos);
+	chessEvalRemovePiece(&(game->evaluation), prevPiece, square);
+	chessEvalAddPiece(&(game->evaluation), piece, square);
+	chessGameSetPieceByPosition(&(game->gameBoard), pos, piece);
 }
 
 /**
@@ -144,8 +219,10 @@ static CHESS_GAME_MESSAGE chessGameIsValidMove(ChessGame* game,
 }
 
 /**
- *  Checks if the given position is threatened, by going over all the pieces on
- *  board and testing if they can make a move to that position.
+ *  Checks if the piece in the given position is threatened, by looking from
+ *  the position for opponent's pieces which attack it: pawns, knights and
+ *  kings on their fixed squares, and bishops, rooks and queens along their
+ *  lines. An empty position is never threatened.
  *  @param game
  *  @param pos - the potentially threatened position
  *  @param checkKing -  For any threatening position, should we check if the
@@ -160,30 +237,31 @@ static bool isPositionThreatened(ChessGame* game, ChessPiecePosition pos,
 bool checkKing) {
 	ChessPiece piece = getPieceByPosition(game, pos);
 	ChessPiecePosition threatPos;
-	for (int i = 0; i < CHESS_N_ROWS; i++)
-		for (int j = 0; j < CHESS_N_COLUMNS; j++) {
-			threatPos = (ChessPiecePosition ) { .row = i, .column = j };
-			if (chessMoveIsValidMove(&(game->gameBoard), threatPos, pos)) {
-				// need to perform the move in order to check king threats
-				if (checkKing) {
-					ChessPiece threatPiece = getPieceByPosition(game,
-							threatPos);
-					// Change board to test for threats
-					setPieceInPosition(game, pos, threatPiece);
-					setPieceInPosition(game, threatPos, EMPTY_ENTRY);
-
-					bool res = isKingThreatened(game, threatPiece.player);
-
-					// Undo changes to board
-					setPieceInPosition(game, threatPos, threatPiece);
-					setPieceInPosition(game, pos, piece);
-					if (res)
-						continue;
-				}
-				return true;
-			}
+	ChessBoard* board = &(game->gameBoard);
+	if (piece.type == CHESS_PIECE_EMPTY)
+		return false;
+	ChessBitboard threatSquares = chessMoveGetAttackers(board,
+			chessGamePositionToSquare(pos), chessGameGetOccupied(board))
+			& board->occupied[chessGameGetOpponentByPlayer(piece.player)];
+	if (!checkKing)
+		return threatSquares != 0;
+	while (threatSquares) {
+		threatPos = chessGameSquareToPosition(
+				chessBitboardPopFirstSquare(&threatSquares));
+		// need to perform the move in order to check king threats
+		ChessPiece threatPiece = getPieceByPosition(game, threatPos);
+		// Change board to test for threats
+		setPieceInPosition(game, pos, threatPiece);
+		setPieceInPosition(game, threatPos, EMPTY_ENTRY);
 
-		}
+		bool res = isKingThreatened(game, threatPiece.player);
+
+		// Undo changes to board
+		setPieceInPosition(game, threatPos, threatPiece);
+		setPieceInPosition(game, pos, piece);
+		if (!res)
+			return true;
+	}
 	return false;
 }
 
@@ -216,6 +294,150 @@ static short getCurrentOpponent(ChessGame* game) {
  */
 static void changePlayer(ChessGame* game) {
 	game->currentPlayer = getCurrentOpponent(game);
+	game->hash ^= zobristWhitePlayer;
+}
+
+/**
+ * Checks if the player's king is attacked by any of the opponent's pieces.
+ * A player without a king is never attacked.
+ */
+static bool isKingAttacked(ChessBoard* board, int player) {
+	ChessBitboard king = board->pieces[player][CHESS_PIECE_KING];
+	if (king == 0)
+		return false;
+	return (chessMoveGetAttackers(board, chessBitboardFirstSquare(king),
+			chessGameGetOccupied(board))
+			& board->occupied[chessGameGetOpponentByPlayer(player)]) != 0;
+}
+
+/**
+ * Checks if the move just played on the board checks the opponent's king,
+ * either directly by the moved piece, or by a slider behind the vacated square.
+ * Only these two can check, as there is no castling, en passant or promotion.
+ */
+static bool isCheckingMove(ChessBoard* board, ChessMove move, int player) {
+	int opponent = chessGameGetOpponentByPlayer(player);
+	ChessBitboard king = board->pieces[opponent][CHESS_PIECE_KING];
+	if (king == 0)
+		return false;
+	int kingSquare = chessBitboardFirstSquare(king);
+	int from = chessGamePositionToSquare(move.previousPosition);
+	int to = chessGamePositionToSquare(move.currentPosition);
+	ChessBitboard occupied = chessGameGetOccupied(board);
+	ChessBitboard* pieces = board->pieces[player];
+	ChessBitboard attacks = 0;
+
+	// Direct check
+	switch (chessGameGetPieceByPosition(board, move.currentPosition).type) {
+	case CHESS_PIECE_PAWN:
+		attacks = chessMoveGetPawnAttacks(to, player);
+		break;
+	case CHESS_PIECE_BISHOP:
+		attacks = chessMoveGetBishopAttacks(to, occupied);
+		break;
+	case CHESS_PIECE_KNIGHT:
+		attacks = chessMoveGetKnightAttacks(to);
+		break;
+	case CHESS_PIECE_ROOK:
+		attacks = chessMoveGetRookAttacks(to, occupied);
+		break;
+	case CHESS_PIECE_QUEEN:
+		attacks = chessMoveGetQueenAttacks(to, occupied);
+		break;
+	default:
+		break;
+	}
+	if (attacks & king)
+		return true;
+
+	// Discovered check, by a slider on the line from the king through the vacated square
+	ChessBitboard line = chessMoveGetLine(kingSquare, from);
+	if (line == 0)
+		return false;
+	ChessBitboard sliders = (chessMoveGetBishopAttacks(kingSquare, occupied)
+			& (pieces[CHESS_PIECE_BISHOP] | pieces[CHESS_PIECE_QUEEN]))
+			| (chessMoveGetRookAttacks(kingSquare, occupied)
+					& (pieces[CHESS_PIECE_ROOK] | pieces[CHESS_PIECE_QUEEN]));
+	return (sliders & line & ~chessBitboardSquare(to)) != 0;
+}
+
+/**
+ * Allocates a history of the given size.
+ * Returns NULL if size isn't positive or a memory allocation failure occurred.
+ */
+static ChessUndoRecord* historyCreate(int size) {
+	if (size <= 0)
+		return NULL;
+	ChessUndoRecord* history = malloc(size * sizeof(ChessUndoRecord));
+	if (history == NULL)
+		hadMemoryFailure();
+	return history;
+}
+
+/**
+ * Creates the undo record of the move, holding the game's state before the
+ * move is played.
+ */
+static ChessUndoRecord createUndoRecord(ChessGame* game, ChessMove move) {
+	ChessUndoRecord record;
+	move.isThreatened = false;
+	record.move = move;
+	record.whiteKingPosition = game->whiteKingPosition;
+	record.blackKingPosition = game->blackKingPosition;
+	record.isCheck = game->isCheck;
+	record.hash = game->hash;
+	record.evaluation = game->evaluation;
+	return record;
+}
+
+/**
+ * Takes back a move played on the board, restoring the game's state from the
+ * move's undo record. The board is changed directly, as the hash and the
+ * evaluation are restored from the record.
+ */
+static void restoreUndoRecord(ChessGame* game, ChessUndoRecord* record) {
+	ChessBoard* board = &(game->gameBoard);
+	ChessMove move = record->move;
+	ChessPiece piece = chessGameGetPieceByPosition(board, move.currentPosition);
+	chessGameSetPieceByPosition(board, move.previousPosition, piece);
+	chessGameSetPieceByPosition(board, move.currentPosition,
+			move.capturedPiece);
+	game->currentPlayer = piece.player;
+	game->whiteKingPosition = record->whiteKingPosition;
+	game->blackKingPosition = record->blackKingPosition;
+	game->isCheck = record->isCheck;
+	game->hash = record->hash;
+	game->evaluation = record->evaluation;
+}
+
+/**
+ * Gets the index in the history of the record offset records after the oldest.
+ * Assumes offset is between 0 and historySize - 1.
+ */
+static int getHistoryIndex(ChessGame* game, int offset) {
+	int index = game->historyHead + offset;
+	return index < game->historySize ? index : index - game->historySize;
+}
+
+/**
+ * Completes a move which was already played on the board: changes the current
+ * player, adds the move's record to the history and updates the check state
+ * from the move. Once the history is full the oldest record is overwritten.
+ */
+static void finishMove(ChessGame* game, ChessUndoRecord* record) {
+	// Update history
+	if (game->historyCount == game->historySize) {
+		game->history[game->historyHead] = *record;
+		game->historyHead = getHistoryIndex(game, 1);
+	} else
+		game->history[getHistoryIndex(game, game->historyCount++)] = *record;
+
+	// Update threatening position.
+	game->isCheck = isCheckingMove(&(game->gameBoard), record->move,
+			chessGameGetCurrentPlayer(game));
+
+	// Update current player
+	changePlayer(game);
 }
 
 /**
@@ -228,6 +450,7 @@ static void changePlayer(ChessGame* game) {
 static ChessBoard chessBoardCreate() {
 	ChessBoard board;
 	ChessPiece piece;
+	memset(&board, 0, sizeof(ChessBoard));
 	for (int i = 0; i < CHESS_N_ROWS; i++)
 		for (int j = 0; j < CHESS_N_COLUMNS; j++) {
 			bool isWhite = i == WHITE_OTHER_ROW;
@@ -264,7 +487,8 @@ static ChessBoard chessBoardCreate() {
 			default:
 				piece = EMPTY_ENTRY;
 			}
-			board.position[i][j] = piece;
+			chessGameSetPieceByPosition(&board,
+					(ChessPiecePosition ) { .row = i, .column = j }, piece);
 		}
 	return board;
 }
@@ -277,16 +501,35 @@ static ChessBoard chessBoardCreate() {
  * Otherwise, a new game instance is returned.
  */
 ChessGame* chessGameCreate() {
-	ArrayList* list = arrayListCreate(HISTORY_SIZE);
-	if (list == NULL)
+	return chessGameCreateWithHistorySize(HISTORY_SIZE);
+}
+
+/**
+ * Creates a new game, with a history of the given size. The history keeps the
+ * last historySize moves, which can be undone.
+ *
+ * @param historySize - The size of the history, must be positive.
+ *
+ * @return
+ * NULL if historySize isn't positive or a memory allocation failure occurs.
+ * Otherwise, a new game instance is returned.
+ */
+ChessGame* chessGameCreateWithHistorySize(int historySize) {
+	chessMoveInitAttackTables();
+	initZobristKeys();
+	ChessUndoRecord* history = historyCreate(historySize);
+	if (history == NULL)
 		return NULL;
 	ChessGame* game = malloc(sizeof(ChessGame));
 	if (game == NULL) {
 		hadMemoryFailure();
+		free(history);
 		return NULL;
 	}
-	game->historySize = HISTORY_SIZE;
-	game->history = list;
+	game->historySize = historySize;
+	game->historyHead = 0;
+	game->historyCount = 0;
+	game->history = history;
 	game->currentPlayer = CHESS_WHITE_PLAYER;
 	game->gameBoard = chessBoardCreate();
 	game->whiteKingPosition = (ChessPiecePosition ) { WHITE_OTHER_ROW,
@@ -294,6 +537,8 @@ ChessGame* chessGameCreate() {
 	game->blackKingPosition = (ChessPiecePosition ) { BLACK_OTHER_ROW,
 			KING_COLUMN };
 	game->isCheck = false;
+	game->hash = computeHash(game);
+	game->evaluation = computeEvaluation(game);
 	return game;
 }
 
@@ -310,15 +555,17 @@ ChessGame* chessGameCreate() {
 ChessGame* chessGameCopy(ChessGame* src) {
 	if (src == NULL)
 		return NULL;
-	ArrayList* history = arrayListCopy(src->history);
+	ChessUndoRecord* history = historyCreate(src->historySize);
 	if (history == NULL)
 		return NULL;
 	ChessGame* game = malloc(sizeof(ChessGame));
 	if (game == NULL) {
 		hadMemoryFailure();
+		free(history);
 		return NULL;
 	}
 	*game = *src;
+	memcpy(history, src->history, src->historySize * sizeof(ChessUndoRecord));
 	game->history = history;
 	return game;
 }
@@ -336,15 +583,19 @@ ChessGame* chessGameCopy(ChessGame* src) {
 ChessGame* chessGameCopyEmptyHistory(ChessGame* src, int historySize) {
 	if (src == NULL)
 		return NULL;
-	ArrayList* history = arrayListCreate(historySize);
+	ChessUndoRecord* history = historyCreate(historySize);
 	if (history == NULL)
 		return NULL;
 	ChessGame* game = malloc(sizeof(ChessGame));
 	if (game == NULL) {
 		hadMemoryFailure();
+		free(history);
 		return NULL;
 	}
 	*game = *src;
+	game->historySize = historySize;
+	game->historyHead = 0;
+	game->historyCount = 0;
 	game->history = history;
 	return game;
 }
@@ -358,48 +609,262 @@ ChessGame* chessGameCopyEmptyHistory(ChessGame* src, int historySize) {
 void chessGameDestroy(ChessGame* game) {
 	if (game == NULL)
 		return;
-	arrayListDestroy(game->history);
+	free(game->history);
 	free(game);
 }
 
 /**
- * Gets all valid moves for the specified position.
- *
- * @param game - The game. Assumes not NULL.
- * @param pos - The piece's position on board. Assumes not NULL.
- *
- * @return
- * ArrayList with all possible moves
+ * Type used for filtering the legal moves of a player. Computed once per
+ * position instead of testing each move by performing it.
+ * kingSquare - the square of the player's king, -1 if it has no king.
+ * checkers - the opponent's pieces which threaten the king.
+ * pinned - the player's pieces which are the only blocker between the king and
+ * an opponent's bishop, rook or queen.
+ * checkMask - the squares a non-king move must reach to resolve the check.
+ * All squares if not in check, none in a double check.
  */
-ArrayList* chessGameGetMoves(ChessGame* game, ChessPiecePosition pos) {
-	ArrayList* arr = chessMoveGetMoves(&(game->gameBoard), pos);
-	if (arr == NULL)
-		return NULL;
-	ChessPiece piece = getPieceByPosition(game, pos);
+typedef struct legality_masks_t {
+	int kingSquare;
+	ChessBitboard checkers;
+	ChessBitboard pinned;
+	ChessBitboard checkMask;
+} LegalityMasks;
+
+/**
+ * Computes the legality masks of the given player's position.
+ */
+static void computeLegalityMasks(ChessBoard* board, int player,
+		LegalityMasks* masks) {
+	int opponent = chessGameGetOpponentByPlayer(player);
+	ChessBitboard king = board->pieces[player][CHESS_PIECE_KING];
+	ChessBitboard occupied = chessGameGetOccupied(board);
+	ChessBitboard* opponentPieces = board->pieces[opponent];
+	masks->checkers = 0;
+	masks->pinned = 0;
+	masks->checkMask = ~(ChessBitboard) 0;
+	if (king == 0) {
+		masks->kingSquare = -1;
+		return;
+	}
+	masks->kingSquare = chessBitboardFirstSquare(king);
+	masks->checkers = chessMoveGetAttackers(board, masks->kingSquare, occupied)
+			& board->occupied[opponent];
+	if (chessBitboardCount(masks->checkers) > 1)
+		masks->checkMask = 0;
+	else if (masks->checkers)
+		masks->checkMask = masks->checkers
+				| chessMoveGetBetween(masks->kingSquare,
+						chessBitboardFirstSquare(masks->checkers));
+
+	// Opponent's sliders aiming at the king with exactly one piece in between
+	ChessBitboard pinners = (chessMoveGetBishopAttacks(masks->kingSquare, 0)
+			& (opponentPieces[CHESS_PIECE_BISHOP]
+					| opponentPieces[CHESS_PIECE_QUEEN]))
+			| (chessMoveGetRookAttacks(masks->kingSquare, 0)
+					& (opponentPieces[CHESS_PIECE_ROOK]
+							| opponentPieces[CHESS_PIECE_QUEEN]));
+	while (pinners) {
+		int square = chessBitboardPopFirstSquare(&pinners);
+		ChessBitboard blockers = chessMoveGetBetween(masks->kingSquare, square)
+				& occupied;
+		if (chessBitboardCount(blockers) == 1)
+			masks->pinned |= blockers & board->occupied[player];
+	}
+}
+
+/**
+ * Checks if the move leaves the moving player's king safe, given the player's
+ * legality masks. King moves are checked directly for threats on the target,
+ * as if the king has already left its square.
+ */
+static bool isLegalMove(ChessBoard* board, LegalityMasks* masks,
+		ChessMove move, int player) {
+	if (masks->kingSquare < 0)
+		return true;
+	int from = chessGamePositionToSquare(move.previousPosition);
+	int to = chessGamePositionToSquare(move.currentPosition);
+	if (from == masks->kingSquare) {
+		ChessBitboard occupied = chessGameGetOccupied(board)
+				& ~chessBitboardSquare(from);
+		ChessBitboard attackers = chessMoveGetAttackers(board, to, occupied)
+				& board->occupied[chessGameGetOpponentByPlayer(player)];
+		return (attackers & ~chessBitboardSquare(to)) == 0;
+	}
+	if (!(masks->checkMask & chessBitboardSquare(to)))
+		return false;
+	if ((masks->pinned & chessBitboardSquare(from))
+			&& !(chessMoveGetLine(masks->kingSquare, from)
+					& chessBitboardSquare(to)))
+		return false;
+	return true;
+}
+
+/**
+ * Removes the moves from index start of the buffer which threaten their own
+ * king. All moves are assumed to be of the same player. The legality is
+ * checked against the pins and checks of the position.
+ */
+static void filterLegalMoves(ChessGame* game, ChessMoveBuffer* buffer,
+		int start) {
+	ChessPiece piece;
+	LegalityMasks masks;
+	int size = start;
+	if (start >= buffer->size)
+		return;
+	piece = getPieceByPosition(game, buffer->moves[start].previousPosition);
+	computeLegalityMasks(&(game->gameBoard), piece.player, &masks);
+	for (int i = start; i < buffer->size; i++)
+		if (isLegalMove(&(game->gameBoard), &masks, buffer->moves[i],
+				piece.player))
+			buffer->moves[size++] = buffer->moves[i];
+	buffer->size = size;
+}
+
+/**
+ * Updates isThreatened of the moves from index start of the buffer.
+ * The threat on each move is tested by performing it on the board and undoing
+ * it. Only needed for displaying the moves, the search never reads it.
+ */
+static void updateThreatenedMoves(ChessGame* game, ChessMoveBuffer* buffer,
+		int start) {
+	ChessPiece piece;
 	ChessPiece capturedPiece;
+	ChessPiecePosition pos;
 	ChessPiecePosition nextPos;
-	for (int i = 0; i < arr->actualSize; i++) {
-		ChessMove move = arrayListGetAt(arr, i);
-		capturedPiece = move.capturedPiece;
-		nextPos = move.currentPosition;
+	for (int i = start; i < buffer->size; i++) {
+		ChessMove* move = &(buffer->moves[i]);
+		pos = move->previousPosition;
+		nextPos = move->currentPosition;
+		piece = getPieceByPosition(game, pos);
+		capturedPiece = move->capturedPiece;
 
-		// Change board to test for threats
+		// Change board to test for threats on the new position
 		setPieceInPosition(game, nextPos, piece);
 		setPieceInPosition(game, pos, EMPTY_ENTRY);
-
-		// Remove moves that threatens the king
-		if (isKingThreatened(game, piece.player)) {
-			arrayListRemoveAt(arr, i);
-			i--;
-		} else if (isPositionThreatened(game, nextPos, true)) {
-			arrayListIsThreatened(arr, i, true);
-		}
+		move->isThreatened = isPositionThreatened(game, nextPos, true);
 
 		// Undo changes to board
 		setPieceInPosition(game, pos, piece);
 		setPieceInPosition(game, nextPos, capturedPiece);
 	}
-	return arr;
+}
+
+/**
+ * Adds all valid moves for the specified position to the end of the buffer.
+ * Doesn't update the isThreatened field of the moves.
+ *
+ * @param game - The game. Assumes not NULL.
+ * @param pos - The piece's position on board.
+ * @param buffer - The caller's move buffer. Assumes not NULL.
+ */
+void chessGameGenerateMoves(ChessGame* game, ChessPiecePosition pos,
+		ChessMoveBuffer* buffer) {
+	int start = buffer->size;
+	chessMoveGenerateMoves(&(game->gameBoard), pos, buffer);
+	filterLegalMoves(game, buffer, start);
+}
+
+/**
+ * Adds all valid moves of the current player to the end of the buffer.
+ * The moves are ordered by the position of the moving piece, row by row.
+ * Doesn't update the isThreatened field of the moves.
+ *
+ * @param game - The game. Assumes not NULL.
+ * @param buffer - The caller's move buffer. Assumes not NULL.
+ */
+void chessGameGenerateAllMoves(ChessGame* game, ChessMoveBuffer* buffer) {
+	int start = buffer->size;
+	chessMoveGenerateAllMoves(&(game->gameBoard),
+			chessGameGetCurrentPlayer(game), buffer);
+	filterLegalMoves(game, buffer, start);
+}
+
+/**
+ * Adds all moves of the current player to the end of the buffer, including
+ * the ones which threaten the player's king. Meant for the search, which plays
+ * the moves with chessGameSetPseudoLegalMove and skips the rejected ones.
+ * The moves are ordered the same as in chessGameGenerateAllMoves.
+ *
+ * @param game - The game. Assumes not NULL.
+ * @param buffer - The caller's move buffer. Assumes not NULL.
+ */
+void chessGameGeneratePseudoLegalMoves(ChessGame* game,
+		ChessMoveBuffer* buffer) {
+	chessMoveGenerateAllMoves(&(game->gameBoard),
+			chessGameGetCurrentPlayer(game), buffer);
+}
+
+/**
+ * Checks if any of the moves in the buffer is legal, given
+ * the player's legality masks.
+ */
+static bool hasLegalMoveInBuffer(ChessBoard* board, LegalityMasks* masks,
+		ChessMoveBuffer* buffer, int player) {
+	for (int i = 0; i < buffer->size; i++)
+		if (isLegalMove(board, masks, buffer->moves[i], player))
+			return true;
+	return false;
+}
+
+/**
+ * Checks if the current player has any legal move, stopping at the first one
+ * found. The king's moves are tried first, as they are the only moves out of a
+ * double check and the likeliest ones out of a single check.
+ *
+ * @param game - The game. Assumes not NULL.
+ *
+ * @return
+ * true if the current player has a legal move, false otherwise.
+ */
+bool chessGameHasLegalMove(ChessGame* game) {
+	ChessBoard* board = &(game->gameBoard);
+	int player = chessGameGetCurrentPlayer(game);
+	ChessBitboard pieces = board->occupied[player];
+	LegalityMasks masks;
+	ChessMoveBuffer moves;
+	computeLegalityMasks(board, player, &masks);
+
+	// King escapes first, no other piece can move in a double check
+	if (masks.kingSquare >= 0) {
+		moves.size = 0;
+		chessMoveGenerateMoves(board,
+				chessGameSquareToPosition(masks.kingSquare), &moves);
+		if (hasLegalMoveInBuffer(board, &masks, &moves, player))
+			return true;
+		if (masks.checkMask == 0)
+			return false;
+		pieces &= ~chessBitboardSquare(masks.kingSquare);
+	}
+	while (pieces) {
+		moves.size = 0;
+		chessMoveGenerateMoves(board,
+				chessGameSquareToPosition(chessBitboardPopFirstSquare(&pieces)),
+				&moves);
+		if (hasLegalMoveInBuffer(board, &masks, &moves, player))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Gets all valid moves for the specified position, with the isThreatened
+ * field of each move updated.
+ *
+ * @param game - The game. Assumes not NULL.
+ * @param pos - The piece's position on board. Assumes not NULL.
+ *
+ * @return
+ * ArrayList with all possible moves
+ */
+ArrayList* chessGameGetMoves(ChessGame* game, ChessPiecePosition pos) {
+	if (!chessGameIsValidPosition(pos))
+		return NULL;
+	ChessMoveBuffer buffer;
+	buffer.size = 0;
+	chessGameGenerateMoves(game, pos, &buffer);
+	updateThreatenedMoves(game, &buffer, 0);
+	return chessMoveBufferToArrayList(&buffer,
+			chessMoveGetMaxMoves(getPieceByPosition(game, pos)));
 }
 
 /**
@@ -424,33 +889,74 @@ CHESS_GAME_MESSAGE chessGameSetMove(ChessGame* game, ChessPiecePosition cur_pos,
 
 	// Update board
 	ChessPiece piece = getPieceByPosition(game, cur_pos);
-	ChessPiece capturedPiece = getPieceByPosition(game, next_pos);
+	ChessMove move = { .previousPosition = cur_pos, .currentPosition = next_pos,
+			.capturedPiece = getPieceByPosition(game, next_pos) };
+	ChessUndoRecord record = createUndoRecord(game, move);
 	setPieceInPosition(game, next_pos, piece);
 	setPieceInPosition(game, cur_pos, EMPTY_ENTRY);
 
 	// Checks if after we made our move, our king is threatened. If so, undo.
 	if (isKingThreatened(game, chessGameGetCurrentPlayer(game))) {
-		setPieceInPosition(game, cur_pos, piece);
-		setPieceInPosition(game, next_pos, capturedPiece);
+		restoreUndoRecord(game, &record);
 		return game->isCheck ?
 				CHESS_GAME_UNRESOLVED_THREATENED_KING :
 				CHESS_GAME_MOVE_THREATEN_KING;
 	}
 
-	// Update current player
-	changePlayer(game);
+	finishMove(game, &record);
+	return res;
+}
 
-	// Update history
-	ArrayList* history = game->history;
-	ChessMove move = { .previousPosition = cur_pos, .currentPosition = next_pos,
-			.capturedPiece = capturedPiece };
-	if (arrayListIsFull(history))
-		arrayListRemoveFirst(history);
-	arrayListAddLast(history, move);
+/**
+ * Sets a move generated by chessGameGeneratePseudoLegalMoves, skipping the
+ * validation of chessGameSetMove. The threat on the player's king is only
+ * checked after the move is played, by looking for attackers of the king.
+ *
+ * @param game - The source game. Assumes not NULL.
+ * @param move - A valid move of the current player, ignoring king threats.
+ *
+ * @return
+ * CHESS_GAME_MOVE_THREATEN_KING - if the move leaves the player's king
+ *                                 threatened. The move is undone.
+ * CHESS_GAME_SUCCESS - otherwise
+ */
+CHESS_GAME_MESSAGE chessGameSetPseudoLegalMove(ChessGame* game,
+		ChessMove move) {
+	int player = chessGameGetCurrentPlayer(game);
+	ChessPiece piece = getPieceByPosition(game, move.previousPosition);
+	ChessUndoRecord record = createUndoRecord(game, move);
+	setPieceInPosition(game, move.currentPosition, piece);
+	setPieceInPosition(game, move.previousPosition, EMPTY_ENTRY);
+	if (isKingAttacked(&(game->gameBoard), player)) {
+		restoreUndoRecord(game, &record);
+		return CHESS_GAME_MOVE_THREATEN_KING;
+	}
+	finishMove(game, &record);
+	return CHESS_GAME_SUCCESS;
+}
 
-	// Update threatening position.
-	chessGameUpdateIsCheck(game);
-	return res;
+/**
+ * Passes the turn to the opponent without moving a piece. Meant for the
+ * search's null move pruning. The pass isn't added to the history, so it must
+ * be undone with chessGameUndoNullMove before any earlier move is undone.
+ *
+ * @param game - The source game. Assumes not NULL and not in check.
+ */
+void chessGameSetNullMove(ChessGame* game) {
+	// The opponent's king can't be threatened on the player's turn
+	changePlayer(game);
+	game->isCheck = false;
+}
+
+/**
+ * Undoes a pass of the turn set by chessGameSetNullMove.
+ *
+ * @param game - The source game. Assumes not NULL, and that the last move set
+ *               was a null move.
+ */
+void chessGameUndoNullMove(ChessGame* game) {
+	changePlayer(game);
+	game->isCheck = false;
 }
 
 /**
@@ -465,18 +971,35 @@ CHESS_GAME_MESSAGE chessGameSetMove(ChessGame* game, ChessPiecePosition cur_pos,
  * 								 and the current player is changed.
  */
 CHESS_GAME_MESSAGE chessGameUndoMove(ChessGame* game) {
-	ArrayList* history = game->history;
-	if (arrayListIsEmpty(history))
+	if (game->historyCount == 0)
 		return CHESS_GAME_EMPTY_HISTORY;
-	ChessMove move = arrayListGetLast(history);
-	ChessPiece currPiece = getPieceByPosition(game, move.currentPosition);
-	setPieceInPosition(game, move.previousPosition, currPiece);
-	setPieceInPosition(game, move.currentPosition, move.capturedPiece);
-	arrayListRemoveLast(history);
-	changePlayer(game);
+	restoreUndoRecord(game,
+			&(game->history[getHistoryIndex(game, --game->historyCount)]));
 	return CHESS_GAME_SUCCESS;
 }
 
+/**
+ * Checks if the history of the specified game is empty, meaning there is no
+ * move to undo.
+ * @param game - Assume not null
+ * @return
+ * true if the history is empty, false otherwise.
+ */
+bool chessGameIsHistoryEmpty(ChessGame* game) {
+	return game->historyCount == 0;
+}
+
+/**
+ * Returns the last move of the specified game, the one chessGameUndoMove
+ * would undo.
+ * @param game - Assume not null, with a non empty history.
+ * @return
+ * The last move in the history.
+ */
+ChessMove chessGameGetLastMove(ChessGame* game) {
+	return game->history[getHistoryIndex(game, game->historyCount - 1)].move;
+}
+
 /**
  * On success, the function prints the board game to the file given.
  * Uses the defined representation of each piece.
@@ -518,6 +1041,53 @@ int chessGameGetCurrentPlayer(ChessGame* game) {
 	return game->currentPlayer;
 }
 
+/**
+ * Sets the current player of the specified game, and updates its hash.
+ * @param game - Assume not null
+ * @param player - CHESS_WHITE_PLAYER or CHESS_BLACK_PLAYER
+ */
+void chessGameSetCurrentPlayer(ChessGame* game, int player) {
+	if (game->currentPlayer != player)
+		changePlayer(game);
+}
+
+/**
+ * Sets the given piece in the given position of the specified game's board,
+ * regardless of the game's rules. Updates the kings' positions and the hash.
+ * Meant for setting up a position, e.g. when loading a game. Call
+ * chessGameUpdateIsCheck once the position is set up.
+ * @param game - Assume not null
+ * @param pos - the position, does nothing if invalid.
+ * @param piece - the piece to set, may be an empty piece.
+ */
+void chessGameSetPiece(ChessGame* game, ChessPiecePosition pos,
+		ChessPiece piece) {
+	if (chessGameIsValidPosition(pos))
+		setPieceInPosition(game, pos, piece);
+}
+
+/**
+ * Returns the hash of the specified game's position. Equal positions with the
+ * same player to move have the same hash.
+ * @param game - Assume not null
+ * @return
+ * game->hash
+ */
+uint64_t chessGameGetHash(ChessGame* game) {
+	return game->hash;
+}
+
+/**
+ * Returns the static evaluation of the specified game's position: the
+ * material and piece-square scores, kept up to date as pieces move.
+ * @param game - Assume not null
+ * @return
+ * The evaluation in centipawns, positive if good for the white player.
+ */
+int chessGameGetEvaluation(ChessGame* game) {
+	return chessEvalGetScore(&(game->evaluation));
+}
+
 /*
  * returns the opponent of the current player.
  * @param player - the current player.
@@ -541,6 +1111,7 @@ void chessGameUpdateIsCheck(ChessGame* game) {
 
 /**
  * Checks if the current state is checkmate, draw or none of them.
+ * Relies on game->isCheck, which is updated by each move and undo.
  * @param game - the source game
  * @return
  *  CHESS_GAME_CHECK		- if the game is in check.
@@ -550,22 +1121,8 @@ void chessGameUpdateIsCheck(ChessGame* game) {
  *	CHESS_GAME_NONE			- if none of the above is true.
  */
 CHESS_GAME_MESSAGE chessGameGetCurrentState(ChessGame* game) {
-	chessGameUpdateIsCheck(game);
-	ChessPiecePosition pos;
-	for (int i = 0; i < CHESS_N_ROWS; i++)
-		for (int j = 0; j < CHESS_N_COLUMNS; j++) {
-			pos = (ChessPiecePosition ) { .row = i, .column = j };
-			if (chessGameGetCurrentPlayer(game)
-					== getPieceByPosition(game, pos).player) {
-				ArrayList* moves = chessGameGetMoves(game, pos);
-				if (moves == NULL)
-					return CHESS_GAME_ERROR;
-				int size = moves->actualSize;
-				arrayListDestroy(moves);
-				if (size > 0)
-					return game->isCheck ? CHESS_GAME_CHECK : CHESS_GAME_NONE;
-			}
-		}
+	if (chessGameHasLegalMove(game))
+		return game->isCheck ? CHESS_GAME_CHECK : CHESS_GAME_NONE;
 	return game->isCheck ? CHESS_GAME_CHECKMATE : CHESS_GAME_DRAW;
 }
 
@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include "ChessGameCommon.h"
 #include "ArrayList.h"
+#include "ChessGameMove.h"
+#include "ChessGameEval.h"
 
 #define WHITE_KING_SYMBOL 'k'
 #define BLACK_KING_SYMBOL 'K'
@@ -15,26 +17,64 @@
  * The container supports the following functions.
  *
  * chessGameCreate           - Creates a new game board
+ * chessGameCreateWithHistorySize - Creates a new game board with a given history size
  * chessGameCopy             - Copies a game board
  * chessGameDestroy          - Frees all memory resources associated with a game
  * chessGameSetMove          - Sets a move on a game board
  * chessGameGetMoves         - Gets all valid moves by a specified piece.
+ * chessGameGenerateMoves    - Adds all valid moves by a specified piece to a buffer.
+ * chessGameGenerateAllMoves - Adds all valid moves of the current player to a buffer.
+ * chessGameGeneratePseudoLegalMoves - Adds all moves of the current player to
+ *                             a buffer, without checking king threats.
+ * chessGameSetPseudoLegalMove - Sets a move generated without checking king threats
+ * chessGameHasLegalMove     - Checks if the current player has any legal move
+ * chessGameSetNullMove      - Passes the turn without moving, for the search
+ * chessGameUndoNullMove     - Undoes a pass of the turn
  * chessGameIsValidMove      - Checks if a move is valid
  * chessGameUndoMove         - Undoes previous move made by the last player
  * chessGamePrintBoard       - Prints the current board
  * chessGameGetCurrentPlayer - Returns the current player
+ * chessGameSetCurrentPlayer - Sets the current player
+ * chessGameSetPiece         - Sets a piece on the board, regardless of the rules
+ * chessGameGetHash          - Returns the hash of the current position
+ * chessGameGetEvaluation    - Returns the static evaluation of the current position
+ * chessGameIsHistoryEmpty   - Checks if there is a move to undo
+ * chessGameGetLastMove      - Returns the last move in the history
  *
  */
 
+/**
+ * Type for a move in the history. Holds the state of the game before the move,
+ * so undoing it restores the state without recomputing anything.
+ */
+typedef struct chess_undo_record_t {
+	ChessMove move;
+	ChessPiecePosition whiteKingPosition;
+	ChessPiecePosition blackKingPosition;
+	bool isCheck;
+	uint64_t hash;
+	ChessEvaluation evaluation;
+} ChessUndoRecord;
+
+/**
+ * The history is a circular buffer of historySize preallocated undo records.
+ * historyHead is the index of the oldest record and historyCount the number of
+ * records, the last record is at historyHead + historyCount - 1 wrapped around
+ * historySize. Once full, each move overwrites the oldest record.
+ */
 typedef struct chess_game_t {
 	ChessBoard gameBoard;
 	int currentPlayer;
 	int historySize;
+	int historyHead;
+	int historyCount;
 	unsigned int maxDepth;
-	ArrayList* history;
+	ChessUndoRecord* history;
 	ChessPiecePosition whiteKingPosition;
 	ChessPiecePosition blackKingPosition;
 	bool isCheck;
+	uint64_t hash;
+	ChessEvaluation evaluation;
 } ChessGame;
 
 /**
@@ -69,6 +109,18 @@ typedef enum chess_game_message_t {
  */
 ChessGame* chessGameCreate();
 
+/**
+ * Creates a new game, with a history of the given size. The history keeps the
+ * last historySize moves, which can be undone.
+ *
+ * @param historySize - The size of the history, must be positive.
+ *
+ * @return
+ * NULL if historySize isn't positive or a memory allocation failure occurs.
+ * Otherwise, a new game instance is returned.
+ */
+ChessGame* chessGameCreateWithHistorySize(int historySize);
+
 /**
  *	Creates a copy of a given game.
  *	The new copy has the same status as the src game.
@@ -119,7 +171,8 @@ CHESS_GAME_MESSAGE chessGameSetMove(ChessGame* game,
 		ChessPiecePosition cur_pos, ChessPiecePosition next_pos);
 
 /**
- * Gets all valid moves for the specified position.
+ * Gets all valid moves for the specified position, with the isThreatened
+ * field of each move updated.
  *
  * @param game - The game. Assumes not NULL.
  * @param pos - The piece's position on board. Assumes not NULL.
@@ -129,6 +182,85 @@ CHESS_GAME_MESSAGE chessGameSetMove(ChessGame* game,
  */
 ArrayList* chessGameGetMoves(ChessGame* game, ChessPiecePosition pos);
 
+/**
+ * Adds all valid moves for the specified position to the end of the buffer.
+ * Unlike chessGameGetMoves, doesn't allocate any memory and doesn't update
+ * the isThreatened field of the moves.
+ *
+ * @param game - The game. Assumes not NULL.
+ * @param pos - The piece's position on board.
+ * @param buffer - The caller's move buffer. Assumes not NULL.
+ */
+void chessGameGenerateMoves(ChessGame* game, ChessPiecePosition pos,
+		ChessMoveBuffer* buffer);
+
+/**
+ * Adds all valid moves of the current player to the end of the buffer, in one
+ * pass over the player's pieces. The moves are ordered by the position of the
+ * moving piece, row by row. Doesn't update the isThreatened field of the moves.
+ *
+ * @param game - The game. Assumes not NULL.
+ * @param buffer - The caller's move buffer. Assumes not NULL.
+ */
+void chessGameGenerateAllMoves(ChessGame* game, ChessMoveBuffer* buffer);
+
+/**
+ * Adds all moves of the current player to the end of the buffer, including
+ * the ones which threaten the player's king. Meant for the search, which plays
+ * the moves with chessGameSetPseudoLegalMove and skips the rejected ones.
+ * The moves are ordered the same as in chessGameGenerateAllMoves.
+ *
+ * @param game - The game. Assumes not NULL.
+ * @param buffer - The caller's move buffer. Assumes not NULL.
+ */
+void chessGameGeneratePseudoLegalMoves(ChessGame* game,
+		ChessMoveBuffer* buffer);
+
+/**
+ * Sets a move generated by chessGameGeneratePseudoLegalMoves, skipping the
+ * validation of chessGameSetMove. The threat on the player's king is only
+ * checked after the move is played, by looking for attackers of the king.
+ *
+ * @param game - The source game. Assumes not NULL.
+ * @param move - A valid move of the current player, ignoring king threats.
+ *
+ * @return
+ * CHESS_GAME_MOVE_THREATEN_KING - if the move leaves the player's king
+ *                                 threatened. The move is undone.
+ * CHESS_GAME_SUCCESS - otherwise
+ */
+CHESS_GAME_MESSAGE chessGameSetPseudoLegalMove(ChessGame* game,
+		ChessMove move);
+
+/**
+ * Checks if the current player has any legal move, stopping at the first one
+ * found. The king's moves are tried first, as they are the only moves out of a
+ * double check and the likeliest ones out of a single check.
+ *
+ * @param game - The game. Assumes not NULL.
+ *
+ * @return
+ * true if the current player has a legal move, false otherwise.
+ */
+bool chessGameHasLegalMove(ChessGame* game);
+
+/**
+ * Passes the turn to the opponent without moving a piece. Meant for the
+ * search's null move pruning. The pass isn't added to the history, so it must
+ * be undone with chessGameUndoNullMove before any earlier move is undone.
+ *
+ * @param game - The source game. Assumes not NULL and not in check.
+ */
+void chessGameSetNullMove(ChessGame* game);
+
+/**
+ * Undoes a pass of the turn set by chessGameSetNullMove.
+ *
+ * @param game - The source game. Assumes not NULL, and that the last move set
+ *               was a null move.
+ */
+void chessGameUndoNullMove(ChessGame* game);
+
 /**
  * Undo the last move on the board and changes the current player's turn.
  * If the user invoked this command more than historySize times in a row, an error occurs.
@@ -142,6 +274,24 @@ ArrayList* chessGameGetMoves(ChessGame* game, ChessPiecePosition pos);
  */
 CHESS_GAME_MESSAGE chessGameUndoMove(ChessGame* game);
 
+/**
+ * Checks if the history of the specified game is empty, meaning there is no
+ * move to undo.
+ * @param game - Assume not null
+ * @return
+ * true if the history is empty, false otherwise.
+ */
+bool chessGameIsHistoryEmpty(ChessGame* game);
+
+/**
+ * Returns the last move of the specified game, the one chessGameUndoMove
+ * would undo.
+ * @param game - Assume not null, with a non empty history.
+ * @return
+ * The last move in the history.
+ */
+ChessMove chessGameGetLastMove(ChessGame* game);
+
 /**
  * On success, the function prints the board game to the file given.
  * Uses the defined representation of each piece.
@@ -159,6 +309,43 @@ void chessGamePrintBoard(ChessGame* game, FILE* file);
  */
 int chessGameGetCurrentPlayer(ChessGame* src);
 
+/**
+ * Sets the current player of the specified game, and updates its hash.
+ * @param game - Assume not null
+ * @param player - CHESS_WHITE_PLAYER or CHESS_BLACK_PLAYER
+ */
+void chessGameSetCurrentPlayer(ChessGame* game, int player);
+
+/**
+ * Sets the given piece in the given position of the specified game's board,
+ * regardless of the game's rules. Updates the kings' positions and the hash.
+ * Meant for setting up a position, e.g. when loading a game. Call
+ * chessGameUpdateIsCheck once the position is set up.
+ * @param game - Assume not null
+ * @param pos - the position, does nothing if invalid.
+ * @param piece - the piece to set, may be an empty piece.
+ */
+void chessGameSetPiece(ChessGame* game, ChessPiecePosition pos,
+		ChessPiece piece);
+
+/**
+ * Returns the hash of the specified game's position. Equal positions with the
+ * same player to move have the same hash.
+ * @param game - Assume not null
+ * @return
+ * game->hash
+ */
+uint64_t chessGameGetHash(ChessGame* game);
+
+/**
+ * Returns the static evaluation of the specified game's position: the
+ * material and piece-square scores, kept up to date as pieces move.
+ * @param game - Assume not null
+ * @return
+ * The evaluation in centipawns, positive if good for the white player.
+ */
+int chessGameGetEvaluation(ChessGame* game);
+
 /*
  * returns the opponent of the current player.
  * @param player - the current player.
@@ -170,6 +357,7 @@ int chessGameGetOpponentByPlayer(int player);
 
 /**
  * Checks if the current state is checkmate, draw or none of them.
+ * Relies on game->isCheck, which is updated by each move and undo.
  * @param game - the source game
  * @return
  * 	CHESS_GAME_DRAW 		- if the game is draw.
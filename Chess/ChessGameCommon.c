@@ -34,6 +34,54 @@ ChessPiece chessGameGetPieceByPosition(ChessBoard* board,
 	return piece;
 }
 
+/**
+ *	Sets the given piece in the specified position and updates the bitboards.
+ *	@param board - the game board.
+ *	@param pos - the position in which the piece will be set.
+ *	@param piece - the piece to set, may be an empty piece.
+ *	If board is NULL or pos is not a valid position on board, does nothing.
+ */
+void chessGameSetPieceByPosition(ChessBoard* board, ChessPiecePosition pos,
+		ChessPiece piece) {
+	if (board == NULL || !chessGameIsValidPosition(pos))
+		return;
+	ChessBitboard bit = chessBitboardSquare(chessGamePositionToSquare(pos));
+	ChessPiece oldPiece = board->position[pos.row][pos.column];
+	if (oldPiece.type != CHESS_PIECE_EMPTY) {
+		board->pieces[oldPiece.player][oldPiece.type] &= ~bit;
+		board->occupied[oldPiece.player] &= ~bit;
+	}
+	if (piece.type != CHESS_PIECE_EMPTY) {
+		board->pieces[piece.player][piece.type] |= bit;
+		board->occupied[piece.player] |= bit;
+	}
+	board->position[pos.row][pos.column] = piece;
+}
+
+/**
+ *	Gets all the occupied squares on the board.
+ *	@param board - the game board, assumes not NULL.
+ *	@return
+ *	A bitboard of the squares containing a piece of any player.
+ */
+ChessBitboard chessGameGetOccupied(ChessBoard* board) {
+	return board->occupied[CHESS_WHITE_PLAYER]
+			| board->occupied[CHESS_BLACK_PLAYER];
+}
+
+/**
+ *	Simple xorshift pseudo random generator, gives the same numbers on each run.
+ *	@param seed - the generator's state, updated on each call. Must not be 0.
+ *	@return
+ *	The next pseudo random number.
+ */
+uint64_t chessGameNextRandom(uint64_t* seed) {
+	*seed ^= *seed >> 12;
+	*seed ^= *seed << 25;
+	*seed ^= *seed >> 27;
+	return *seed * 2685821657736338717ULL;
+}
+
 /**
  *	Checks equality between two given chess positions.
  *	@param pos1 - the first position.
@@ -1,6 +1,7 @@
 #ifndef CHESSGAMECOMMON_H_
 #define CHESSGAMECOMMON_H_
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * ChessGameCommon contain common game types and common functions to be used by all other modules.
@@ -14,6 +15,9 @@
 #define CHESS_NON_PLAYER -1
 #define CHESS_START_ROW_CHAR 'A'
 #define CHESS_START_COLUMN_CHAR '1'
+#define CHESS_N_PLAYERS 2
+#define CHESS_N_PIECE_TYPES 6
+#define CHESS_N_SQUARES (CHESS_N_ROWS * CHESS_N_COLUMNS)
 
 /**
  * Enum used for pieces types
@@ -47,12 +51,87 @@ typedef struct chess_game_piece_t {
 } ChessPiece;
 
 /**
- * Type for the chess board
+ * Type for a bitboard, a set of squares on the board using one bit per square.
+ * The square in (row, column) is represented by bit row * CHESS_N_COLUMNS + column.
+ */
+typedef uint64_t ChessBitboard;
+
+/**
+ * Type for the chess board.
+ * The bitboards are kept in sync with position, a bitboard for each player and
+ * piece type and the occupied squares of each player.
+ * NOTE: Use chessGameSetPieceByPosition to change the board.
  */
 typedef struct chess_game_board_t {
 	ChessPiece position[CHESS_N_ROWS][CHESS_N_COLUMNS];
+	ChessBitboard pieces[CHESS_N_PLAYERS][CHESS_N_PIECE_TYPES];
+	ChessBitboard occupied[CHESS_N_PLAYERS];
 } ChessBoard;
 
+/**
+ * Gets the square index of the given position, assumes the position is valid.
+ */
+static inline int chessGamePositionToSquare(ChessPiecePosition pos) {
+	return pos.row * CHESS_N_COLUMNS + pos.column;
+}
+
+/**
+ * Gets the position of the given square index, assumes the index is valid.
+ */
+static inline ChessPiecePosition chessGameSquareToPosition(int square) {
+	ChessPiecePosition pos = { .row = square / CHESS_N_COLUMNS, .column = square
+			% CHESS_N_COLUMNS };
+	return pos;
+}
+
+/**
+ * Gets a bitboard containing only the given square.
+ */
+static inline ChessBitboard chessBitboardSquare(int square) {
+	return (ChessBitboard) 1 << square;
+}
+
+/**
+ * Gets the number of squares in the bitboard.
+ */
+static inline int chessBitboardCount(ChessBitboard bb) {
+	return __builtin_popcountll(bb);
+}
+
+/**
+ * Gets the lowest square in the bitboard, assumes bb is not empty.
+ */
+static inline int chessBitboardFirstSquare(ChessBitboard bb) {
+	return __builtin_ctzll(bb);
+}
+
+/**
+ * Removes the lowest square from the bitboard and returns it.
+ * Assumes *bb is not empty.
+ */
+static inline int chessBitboardPopFirstSquare(ChessBitboard* bb) {
+	int square = chessBitboardFirstSquare(*bb);
+	*bb &= *bb - 1;
+	return square;
+}
+
+/**
+ * Gets the highest square in the bitboard, assumes bb is not empty.
+ */
+static inline int chessBitboardLastSquare(ChessBitboard bb) {
+	return CHESS_N_SQUARES - 1 - __builtin_clzll(bb);
+}
+
+/**
+ * Removes the highest square from the bitboard and returns it.
+ * Assumes *bb is not empty.
+ */
+static inline int chessBitboardPopLastSquare(ChessBitboard* bb) {
+	int square = chessBitboardLastSquare(*bb);
+	*bb &= ~chessBitboardSquare(square);
+	return square;
+}
+
 /**
  *	Checks if the given chess position is valid.
  *	@param pos - the position to validate
@@ -74,6 +153,32 @@ bool chessGameIsValidPosition(ChessPiecePosition pos);
 ChessPiece chessGameGetPieceByPosition(ChessBoard* board,
 		ChessPiecePosition pos);
 
+/**
+ *	Sets the given piece in the specified position and updates the bitboards.
+ *	@param board - the game board.
+ *	@param pos - the position in which the piece will be set.
+ *	@param piece - the piece to set, may be an empty piece.
+ *	If board is NULL or pos is not a valid position on board, does nothing.
+ */
+void chessGameSetPieceByPosition(ChessBoard* board, ChessPiecePosition pos,
+		ChessPiece piece);
+
+/**
+ *	Gets all the occupied squares on the board.
+ *	@param board - the game board, assumes not NULL.
+ *	@return
+ *	A bitboard of the squares containing a piece of any player.
+ */
+ChessBitboard chessGameGetOccupied(ChessBoard* board);
+
+/**
+ *	Simple xorshift pseudo random generator, gives the same numbers on each run.
+ *	@param seed - the generator's state, updated on each call. Must not be 0.
+ *	@return
+ *	The next pseudo random number.
+ */
+uint64_t chessGameNextRandom(uint64_t* seed);
+
 /**
  *	Checks equality between two given chess positions.
  *	@param pos1 - the first position.
@@ -0,0 +1,179 @@
+#include "ChessGameEval.h"
+
+/**
+ * The piece-square tables, from the white player's side: the first line is the
+ * last row of the board. Black pieces use the tables mirrored by rows.
+ * Pawns can't be promoted, so advanced pawns are only worth a little more.
+ */
+static const int pawnMiddlegameTable[CHESS_N_SQUARES] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 30,  30,  30,  30,  30,  30,  30,  30,
+	 10,  10,  20,  30,  30,  20,  10,  10,
+	  5,   5,  10,  25,  25,  10,   5,   5,
+	  0,   0,   0,  20,  20,   0,   0,   0,
+	  5,  -5, -10,   0,   0, -10,  -5,   5,
+	  5,  10,  10, -20, -20,  10,  10,   5,
+	  0,   0,   0,   0,   0,   0,   0,   0 };
+
+static const int pawnEndgameTable[CHESS_N_SQUARES] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 30,  30,  30,  30,  30,  30,  30,  30,
+	 20,  20,  20,  20,  20,  20,  20,  20,
+	 10,  10,  10,  10,  10,  10,  10,  10,
+	  5,   5,   5,   5,   5,   5,   5,   5,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0 };
+
+static const int bishopTable[CHESS_N_SQUARES] = {
+	-20, -10, -10, -10, -10, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,  10,  10,   5,   0, -10,
+	-10,   5,   5,  10,  10,   5,   5, -10,
+	-10,   0,  10,  10,  10,  10,   0, -10,
+	-10,  10,  10,  10,  10,  10,  10, -10,
+	-10,   5,   0,   0,   0,   0,   5, -10,
+	-20, -10, -10, -10, -10, -10, -10, -20 };
+
+static const int knightTable[CHESS_N_SQUARES] = {
+	-50, -40, -30, -30, -30, -30, -40, -50,
+	-40, -20,   0,   0,   0,   0, -20, -40,
+	-30,   0,  10,  15,  15,  10,   0, -30,
+	-30,   5,  15,  20,  20,  15,   5, -30,
+	-30,   0,  15,  20,  20,  15,   0, -30,
+	-30,   5,  10,  15,  15,  10,   5, -30,
+	-40, -20,   0,   5,   5,   0, -20, -40,
+	-50, -40, -30, -30, -30, -30, -40, -50 };
+
+static const int rookTable[CHESS_N_SQUARES] = {
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  5,  10,  10,  10,  10,  10,  10,   5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	  0,   0,   0,   5,   5,   0,   0,   0 };
+
+static const int queenTable[CHESS_N_SQUARES] = {
+	-20, -10, -10,  -5,  -5, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,   5,   5,   5,   0, -10,
+	 -5,   0,   5,   5,   5,   5,   0,  -5,
+	  0,   0,   5,   5,   5,   5,   0,  -5,
+	-10,   5,   5,   5,   5,   5,   0, -10,
+	-10,   0,   5,   0,   0,   0,   0, -10,
+	-20, -10, -10,  -5,  -5, -10, -10, -20 };
+
+static const int kingMiddlegameTable[CHESS_N_SQUARES] = {
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-20, -30, -30, -40, -40, -30, -30, -20,
+	-10, -20, -20, -20, -20, -20, -20, -10,
+	 20,  20,   0,   0,   0,   0,  20,  20,
+	 20,  30,  10,   0,   0,  10,  30,  20 };
+
+static const int kingEndgameTable[CHESS_N_SQUARES] = {
+	-50, -40, -30, -20, -20, -30, -40, -50,
+	-30, -20, -10,   0,   0, -10, -20, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -30,   0,   0,   0,   0, -30, -30,
+	-50, -30, -30, -30, -30, -30, -30, -50 };
+
+/**
+ * The tables of each piece type, by the order of CHESS_PIECE_TYPE.
+ */
+static const int* const middlegameTables[CHESS_N_PIECE_TYPES] = {
+		pawnMiddlegameTable, bishopTable, knightTable, rookTable, queenTable,
+		kingMiddlegameTable };
+static const int* const endgameTables[CHESS_N_PIECE_TYPES] = {
+		pawnEndgameTable, bishopTable, knightTable, rookTable, queenTable,
+		kingEndgameTable };
+
+/**
+ * The material score of each piece type, by the order of CHESS_PIECE_TYPE.
+ */
+static const int pieceTypeScores[CHESS_N_PIECE_TYPES + 1] = { PAWN_SCORE,
+		BISHOP_SCORE, KNIGHT_SCORE, ROOK_SCORE, QUEEN_SCORE, KING_SCORE, 0 };
+
+/**
+ * The phase each piece type adds, by the order of CHESS_PIECE_TYPE.
+ */
+static const int phaseWeights[CHESS_N_PIECE_TYPES] = { 0, 1, 1, 2, 4, 0 };
+
+/**
+ * Gets the index in the tables of a piece of the player in the given square.
+ */
+static int getTableIndex(int player, int square) {
+	int row = square / CHESS_N_COLUMNS;
+	int column = square % CHESS_N_COLUMNS;
+	if (player == CHESS_WHITE_PLAYER)
+		row = CHESS_N_ROWS - 1 - row;
+	return row * CHESS_N_COLUMNS + column;
+}
+
+/**
+ * Adds the scores of the piece to the evaluation, sign is 1 for an added piece
+ * and -1 for a removed one.
+ */
+static void updateEvaluation(ChessEvaluation* eval, ChessPiece piece,
+		int square, int sign) {
+	if (piece.type == CHESS_PIECE_EMPTY)
+		return;
+	int index = getTableIndex(piece.player, square);
+	int material = pieceTypeScores[piece.type];
+	int scoreSign = piece.player == CHESS_WHITE_PLAYER ? sign : -sign;
+	eval->middlegame += scoreSign
+			* (material + middlegameTables[piece.type][index]);
+	eval->endgame += scoreSign * (material + endgameTables[piece.type][index]);
+	eval->phase += sign * phaseWeights[piece.type];
+}
+
+/**
+ * Gets the evaluation of an empty board.
+ */
+ChessEvaluation chessEvalCreate() {
+	ChessEvaluation eval = { .middlegame = 0, .endgame = 0, .phase = 0 };
+	return eval;
+}
+
+/**
+ * Updates the evaluation with a piece added to the given square.
+ * Does nothing if the piece is empty.
+ */
+void chessEvalAddPiece(ChessEvaluation* eval, ChessPiece piece, int square) {
+	updateEvaluation(eval, piece, square, 1);
+}
+
+/**
+ * Updates the evaluation with a piece removed from the given square.
+ * Does nothing if the piece is empty.
+ */
+void chessEvalRemovePiece(ChessEvaluation* eval, ChessPiece piece, int square) {
+	updateEvaluation(eval, piece, square, -1);
+}
+
+/**
+ * Gets the score of the evaluation, the middlegame and endgame scores blended
+ * by the phase.
+ */
+int chessEvalGetScore(ChessEvaluation* eval) {
+	// Promotions aren't possible, but a loaded game may have extra pieces
+	int phase = eval->phase > CHESS_EVAL_MAX_PHASE ?
+			CHESS_EVAL_MAX_PHASE : eval->phase;
+	return (eval->middlegame * phase
+			+ eval->endgame * (CHESS_EVAL_MAX_PHASE - phase))
+			/ CHESS_EVAL_MAX_PHASE;
+}
+
+/**
+ * Gets the material score of a piece type, 0 for an empty piece.
+ */
+int chessEvalGetPieceTypeScore(CHESS_PIECE_TYPE type) {
+	return pieceTypeScores[type];
+}
@@ -0,0 +1,68 @@
+#ifndef CHESSGAMEEVAL_H_
+#define CHESSGAMEEVAL_H_
+#include "ChessGameCommon.h"
+
+/**
+ * ChessGameEval contains the static evaluation of a board: the material of
+ * both players and the piece-square tables, which score each piece by its
+ * square. The tables have a middlegame and an endgame score, blended by the
+ * phase of the game, which is derived from the pieces left on the board.
+ * The evaluation is kept up to date incrementally, as pieces are added and
+ * removed, so reading it doesn't scan the board.
+ * All scores are in centipawns, positive scores are good for the white player.
+ */
+
+/*
+ * Definitions for pieces' scores
+ */
+#define PAWN_SCORE 100
+#define KNIGHT_SCORE 300
+#define BISHOP_SCORE 300
+#define ROOK_SCORE 500
+#define QUEEN_SCORE 900
+#define KING_SCORE 10000
+
+/*
+ * The phase of a board with all pieces but the pawns and kings, counting down
+ * to 0 as they are captured.
+ */
+#define CHESS_EVAL_MAX_PHASE 24
+
+/**
+ * Type for a running evaluation of a board.
+ */
+typedef struct chess_evaluation_t {
+	int middlegame;
+	int endgame;
+	int phase;
+} ChessEvaluation;
+
+/**
+ * Gets the evaluation of an empty board.
+ */
+ChessEvaluation chessEvalCreate();
+
+/**
+ * Updates the evaluation with a piece added to the given square.
+ * Does nothing if the piece is empty.
+ */
+void chessEvalAddPiece(ChessEvaluation* eval, ChessPiece piece, int square);
+
+/**
+ * Updates the evaluation with a piece removed from the given square.
+ * Does nothing if the piece is empty.
+ */
+void chessEvalRemovePiece(ChessEvaluation* eval, ChessPiece piece, int square);
+
+/**
+ * Gets the score of the evaluation, the middlegame and endgame scores blended
+ * by the phase.
+ */
+int chessEvalGetScore(ChessEvaluation* eval);
+
+/**
+ * Gets the material score of a piece type, 0 for an empty piece.
+ */
+int chessEvalGetPieceTypeScore(CHESS_PIECE_TYPE type);
+
+#endif /* CHESSGAMEEVAL_H_ */
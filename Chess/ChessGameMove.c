@@ -5,7 +5,7 @@
 #include "ChessGameMove.h"
 
 /**
- * Declaration of ArrayList maximum size for each piece
+ * Declaration of maximum number of moves for each piece
  */
 static const int pawnArrayMaxSize = 4;
 static const int bishopArrayMaxSize = 13;
@@ -14,6 +14,219 @@ static const int rookArrayMaxSize = 14;
 static const int queenArrayMaxSize = 27;
 static const int kingArrayMaxSize = 8;
 
+/**
+ * Definitions for the magic bitboards attack tables.
+ * For each square, the relevant occupancy (mask) is multiplied by a magic number
+ * and shifted, giving a unique index to the attacks of each occupancy subset.
+ */
+#define ROOK_TABLE_SIZE 102400
+#define BISHOP_TABLE_SIZE 5248
+#define MAX_OCCUPANCY_SUBSETS 4096
+#define MAGIC_MIN_HIGH_BITS 6
+#define FIRST_ROW_BITBOARD 0x00000000000000FFULL
+#define LAST_ROW_BITBOARD 0xFF00000000000000ULL
+#define FIRST_COLUMN_BITBOARD 0x0101010101010101ULL
+#define LAST_COLUMN_BITBOARD 0x8080808080808080ULL
+
+/**
+ * Type for the magic lookup of a single square
+ */
+typedef struct magic_entry_t {
+	ChessBitboard mask;
+	ChessBitboard magic;
+	ChessBitboard* attacks;
+	int shift;
+} MagicEntry;
+
+static const int bishopDirections[4][2] = { { 1, 1 }, { -1, 1 }, { 1, -1 }, {
+		-1, -1 } };
+static const int rookDirections[4][2] =
+		{ { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+/**
+ * Random generator seeds for each row, known to find the magics quickly.
+ */
+static const ChessBitboard magicSeeds[CHESS_N_ROWS] = { 728, 10316, 55013,
+		32803, 12281, 15100, 16645, 255 };
+
+static const int knightSteps[8][2] = { { -2, -1 }, { -2, 1 }, { -1, -2 }, {
+		-1, 2 }, { 1, -2 }, { 1, 2 }, { 2, -1 }, { 2, 1 } };
+static const int kingSteps[8][2] = { { -1, -1 }, { -1, 0 }, { -1, 1 },
+		{ 0, -1 }, { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } };
+
+static bool attackTablesInitialized = false;
+static MagicEntry bishopMagics[CHESS_N_SQUARES];
+static MagicEntry rookMagics[CHESS_N_SQUARES];
+static ChessBitboard bishopTable[BISHOP_TABLE_SIZE];
+static ChessBitboard rookTable[ROOK_TABLE_SIZE];
+static ChessBitboard knightAttacks[CHESS_N_SQUARES];
+static ChessBitboard kingAttacks[CHESS_N_SQUARES];
+static ChessBitboard bishopRays[4][CHESS_N_SQUARES];
+static ChessBitboard rookRays[4][CHESS_N_SQUARES];
+static ChessBitboard pawnAttacks[CHESS_N_PLAYERS][CHESS_N_SQUARES];
+static ChessBitboard betweenSquares[CHESS_N_SQUARES][CHESS_N_SQUARES];
+static ChessBitboard lineSquares[CHESS_N_SQUARES][CHESS_N_SQUARES];
+
+/**
+ * Gets the attacks of a slider in square in a single direction, by walking it
+ * until a blocker is found. Only used to build the attack tables.
+ */
+static ChessBitboard getRayAttacks(int square, ChessBitboard occupied,
+		const int direction[2]) {
+	ChessBitboard attacks = 0;
+	ChessPiecePosition pos = chessGameSquareToPosition(square);
+	while (true) {
+		pos.row += direction[0];
+		pos.column += direction[1];
+		if (!chessGameIsValidPosition(pos))
+			break;
+		ChessBitboard bit = chessBitboardSquare(chessGamePositionToSquare(pos));
+		attacks |= bit;
+		if (occupied & bit)
+			break;
+	}
+	return attacks;
+}
+
+/**
+ * Gets the attacks of a slider in square by walking each of its 4 directions
+ * until a blocker is found. Only used to build the attack tables.
+ */
+static ChessBitboard getSlidingAttacks(int square, ChessBitboard occupied,
+		const int directions[4][2]) {
+	ChessBitboard attacks = 0;
+	for (int d = 0; d < 4; d++)
+		attacks |= getRayAttacks(square, occupied, directions[d]);
+	return attacks;
+}
+
+/**
+ * Finds a magic number for square and fills its attacks in the table.
+ * The entry's attacks pointer should point to a free part of the table.
+ */
+static void initMagicEntry(MagicEntry* entry, int square,
+		const int directions[4][2]) {
+	static ChessBitboard occupancies[MAX_OCCUPANCY_SUBSETS];
+	static ChessBitboard references[MAX_OCCUPANCY_SUBSETS];
+	static int epoch[MAX_OCCUPANCY_SUBSETS];
+	ChessPiecePosition pos = chessGameSquareToPosition(square);
+	ChessBitboard seed = magicSeeds[pos.row];
+	ChessBitboard edges = ((FIRST_ROW_BITBOARD | LAST_ROW_BITBOARD)
+			& ~(FIRST_ROW_BITBOARD << (CHESS_N_COLUMNS * pos.row)))
+			| ((FIRST_COLUMN_BITBOARD | LAST_COLUMN_BITBOARD)
+					& ~(FIRST_COLUMN_BITBOARD << pos.column));
+	entry->mask = getSlidingAttacks(square, 0, directions) & ~edges;
+	entry->shift = CHESS_N_SQUARES - chessBitboardCount(entry->mask);
+
+	// Enumerate all subsets of the mask (Carry-Rippler trick)
+	int size = 0;
+	ChessBitboard subset = 0;
+	do {
+		occupancies[size] = subset;
+		references[size] = getSlidingAttacks(square, subset, directions);
+		epoch[size] = 0;
+		size++;
+		subset = (subset - entry->mask) & entry->mask;
+	} while (subset);
+
+	// Try random sparse numbers until one maps the subsets without collisions
+	int attempt = 0;
+	bool found = false;
+	while (!found) {
+		do {
+			entry->magic = chessGameNextRandom(&seed)
+					& chessGameNextRandom(&seed) & chessGameNextRandom(&seed);
+		} while (chessBitboardCount((entry->mask * entry->magic) >> 56)
+				< MAGIC_MIN_HIGH_BITS);
+		attempt++;
+		found = true;
+		for (int i = 0; i < size && found; i++) {
+			int index = (int) ((occupancies[i] * entry->magic) >> entry->shift);
+			if (epoch[index] < attempt) {
+				epoch[index] = attempt;
+				entry->attacks[index] = references[i];
+			} else if (entry->attacks[index] != references[i])
+				found = false;
+		}
+	}
+}
+
+/**
+ * Gets the squares reached from square by each of the given steps, ignoring
+ * steps which leave the board. Only used to build the attack tables.
+ */
+static ChessBitboard getStepAttacks(int square, const int steps[][2],
+		int numOfSteps) {
+	ChessBitboard attacks = 0;
+	for (int i = 0; i < numOfSteps; i++) {
+		ChessPiecePosition pos = chessGameSquareToPosition(square);
+		pos.row += steps[i][0];
+		pos.column += steps[i][1];
+		if (chessGameIsValidPosition(pos))
+			attacks |= chessBitboardSquare(chessGamePositionToSquare(pos));
+	}
+	return attacks;
+}
+
+/**
+ * Fills the knight, king and pawn attacks of square.
+ */
+static void initStepAttacks(int square) {
+	static const int whitePawnSteps[2][2] = { { 1, -1 }, { 1, 1 } };
+	static const int blackPawnSteps[2][2] = { { -1, -1 }, { -1, 1 } };
+	knightAttacks[square] = getStepAttacks(square, knightSteps, 8);
+	kingAttacks[square] = getStepAttacks(square, kingSteps, 8);
+	pawnAttacks[CHESS_WHITE_PLAYER][square] = getStepAttacks(square,
+			whitePawnSteps, 2);
+	pawnAttacks[CHESS_BLACK_PLAYER][square] = getStepAttacks(square,
+			blackPawnSteps, 2);
+}
+
+/**
+ * Fills the bishop and rook rays of square, the squares in each direction up
+ * to the edge of the board.
+ */
+static void initRays(int square) {
+	for (int d = 0; d < 4; d++) {
+		bishopRays[d][square] = getRayAttacks(square, 0, bishopDirections[d]);
+		rookRays[d][square] = getRayAttacks(square, 0, rookDirections[d]);
+	}
+}
+
+/**
+ * Fills the squares between square and any other square on the same line, and
+ * the full lines through them. Assumes the magic entries are initialized.
+ */
+static void initLines(int square) {
+	for (int other = 0; other < CHESS_N_SQUARES; other++) {
+		ChessBitboard squares = chessBitboardSquare(square)
+				| chessBitboardSquare(other);
+		betweenSquares[square][other] = lineSquares[square][other] = 0;
+		if (square == other)
+			continue;
+		if (chessMoveGetBishopAttacks(square, 0) & chessBitboardSquare(other)) {
+			betweenSquares[square][other] = chessMoveGetBishopAttacks(square,
+					squares) & chessMoveGetBishopAttacks(other, squares);
+			lineSquares[square][other] = (chessMoveGetBishopAttacks(square, 0)
+					& chessMoveGetBishopAttacks(other, 0)) | squares;
+		} else if (chessMoveGetRookAttacks(square, 0)
+				& chessBitboardSquare(other)) {
+			betweenSquares[square][other] = chessMoveGetRookAttacks(square,
+					squares) & chessMoveGetRookAttacks(other, squares);
+			lineSquares[square][other] = (chessMoveGetRookAttacks(square, 0)
+					& chessMoveGetRookAttacks(other, 0)) | squares;
+		}
+	}
+}
+
+/**
+ * Gets the attacks of the square using the magic entry.
+ */
+static ChessBitboard getMagicAttacks(MagicEntry* entry, ChessBitboard occupied) {
+	return entry->attacks[((occupied & entry->mask) * entry->magic)
+			>> entry->shift];
+}
+
 /**
  * Gets the opponent of the piece's player (assumes the piece is a valid piece)
  */
@@ -26,42 +239,37 @@ static int getOpponent(ChessPiece piece) {
  * Checks if a position on board is empty and returns a boolean for it
  */
 static bool isEmptyPosition(ChessBoard* board, ChessPiecePosition pos) {
-	return chessGameGetPieceByPosition(board, pos).type == CHESS_PIECE_EMPTY;
+	return chessGameIsValidPosition(pos)
+			&& !(chessGameGetOccupied(board)
+					& chessBitboardSquare(chessGamePositionToSquare(pos)));
+}
+
+/**
+ * Checks if a position on board contains a piece of the given player
+ */
+static bool isPlayerPosition(ChessBoard* board, ChessPiecePosition pos,
+		int player) {
+	return chessGameIsValidPosition(pos)
+			&& (board->occupied[player]
+					& chessBitboardSquare(chessGamePositionToSquare(pos)));
 }
 
 /**
- * Adds a move by the positions given to the array list.
+ * Adds a move by the positions given to the buffer. The buffer can hold the
+ * moves of any board a game or a loaded file can have, the size check only
+ * guards its memory.
  * NOTE: Sets isThreatened=false. This field should be changed in an advance
  * 		 module (ChessGame module) which look on the entire game.
  * NOTE2: assume the move is valid, doesn't check it.
  */
-static void createAndAddMove(ArrayList* arr, ChessBoard* board,
+static void createAndAddMove(ChessMoveBuffer* buffer, ChessBoard* board,
 		ChessPiecePosition pos, ChessPiecePosition newPos) {
+	if (buffer->size == CHESS_MAX_MOVES)
+		return;
 	ChessMove move = { .previousPosition = pos, .currentPosition = newPos,
 			.capturedPiece = chessGameGetPieceByPosition(board, newPos),
 			.isThreatened = false };
-	arrayListAddLast(arr, move);
-}
-
-/**
- * Attempts to move from pos to newPos given the vertical and horizontal
- * directions (which gets the values of -1, 0 or 1).
- * Checks if the path for pos to newPos in that direction is clear
- * meaning, no pieces in between.
- * NOTE: Assume you give it the right directions!
- * NOTE2: Assume you check if the pieces are of the same player beforehand!
- */
-static bool tryMoveToPosition(ChessBoard* board, ChessPiecePosition pos,
-		ChessPiecePosition newPos, int vDirection, int hDirection) {
-	while (chessGameIsValidPosition(pos)
-			&& !chessGameIsPositionEquals(pos, newPos)) {
-		pos.row += vDirection;
-		pos.column += hDirection;
-		if (!isEmptyPosition(board, pos)
-				&& !chessGameIsPositionEquals(pos, newPos))
-			return false;
-	}
-	return true;
+	buffer->moves[buffer->size++] = move;
 }
 
 /**
@@ -69,38 +277,54 @@ static bool tryMoveToPosition(ChessBoard* board, ChessPiecePosition pos,
  * Only verify that that position is a position on board.
  * NOTE: Assume you check if the positions are of the same player beforehand!
  */
-static void tryAddRelativePosition(ArrayList* arr, ChessBoard* board,
-		ChessPiecePosition pos, int rowAdd, int colAdd) {
+static void tryAddRelativePosition(ChessMoveBuffer* buffer,
+		ChessBoard* board, ChessPiecePosition pos, int rowAdd, int colAdd) {
 	ChessPiecePosition newPos = (ChessPiecePosition ) { .row = pos.row + rowAdd,
 					.column = pos.column + colAdd };
 	if (chessMoveIsValidMove(board, pos, newPos))
-		createAndAddMove(arr, board, pos, newPos);
+		createAndAddMove(buffer, board, pos, newPos);
+}
+
+/**
+ * Adds a move to each of the target squares, capturing if it isn't empty.
+ * The moves are added direction by direction, in the order of directions, and
+ * from the nearest square outward in each direction.
+ * NOTE: Assume you remove the positions of the same player beforehand!
+ */
+static void addMovesToTargets(ChessMoveBuffer* buffer, ChessBoard* board,
+		ChessPiecePosition pos, ChessBitboard targets,
+		const int directions[4][2], ChessBitboard rays[4][CHESS_N_SQUARES]) {
+	int square = chessGamePositionToSquare(pos);
+	for (int d = 0; d < 4; d++) {
+		ChessBitboard rayTargets = targets & rays[d][square];
+		// The squares grow along directions going up the board or right
+		bool isAscending = directions[d][0] > 0
+				|| (directions[d][0] == 0 && directions[d][1] > 0);
+		while (rayTargets) {
+			int target = isAscending ?
+					chessBitboardPopFirstSquare(&rayTargets) :
+					chessBitboardPopLastSquare(&rayTargets);
+			createAndAddMove(buffer, board, pos,
+					chessGameSquareToPosition(target));
+		}
+	}
 }
 
 /**
- * Adds all valid moves in the vertical and horizontal directions, meaning all
- * moves until we collide with another piece (and capture it if not of the same
- * player).
- * NOTE: Assume vDirection and hDirection are in {-1, 0, 1}.
+ * Gets the squares a slider in pos can move to, meaning all the attacked squares
+ * which don't contain a piece of the same player.
  */
-static void addMovesInDirection(ArrayList* arr, ChessBoard* board,
-		ChessPiecePosition pos, int vDirection, int hDirection) {
+static ChessBitboard getSliderTargets(ChessBoard* board, ChessPiecePosition pos,
+		ChessBitboard attacks) {
 	int player = chessGameGetPieceByPosition(board, pos).player;
-	ChessPiecePosition newPos = pos;
-	do {
-		newPos.row += vDirection;
-		newPos.column += hDirection;
-		if (chessGameIsValidPosition(newPos)
-				&& player != chessGameGetPieceByPosition(board, newPos).player)
-			createAndAddMove(arr, board, pos, newPos);
-	} while (chessGameIsValidPosition(newPos) && isEmptyPosition(board, newPos));
+	return attacks & ~board->occupied[player];
 }
 
 /**
- * Simple case switch to get the max size for the array list of moves by piece
- * type. Each piece have different number of maximum possible moves.
+ * Simple case switch to get the max number of moves by piece type.
+ * Each piece have different number of maximum possible moves.
  */
-static int getArraySizeByPieceType(ChessPiece piece) {
+int chessMoveGetMaxMoves(ChessPiece piece) {
 	int size = 0;
 	switch (piece.type) {
 	case CHESS_PIECE_PAWN:
@@ -134,7 +358,6 @@ static int getArraySizeByPieceType(ChessPiece piece) {
 static bool isValidMovePawn(ChessBoard* board, ChessPiecePosition pos,
 		ChessPiecePosition newPos, int rowDiff, int colDiff) {
 	ChessPiece piece = chessGameGetPieceByPosition(board, pos);
-	ChessPiece newPosPiece = chessGameGetPieceByPosition(board, newPos);
 	int pawnDir = piece.player == CHESS_WHITE_PLAYER ? 1 : -1;
 	rowDiff *= pawnDir;
 	int startingRow =
@@ -144,7 +367,7 @@ static bool isValidMovePawn(ChessBoard* board, ChessPiecePosition pos,
 		if (!colDiff && isEmptyPosition(board, newPos)) // regular move
 			return true;
 		else if (colDiff * colDiff == 1
-				&& newPosPiece.player == getOpponent(piece)) // capturing
+				&& isPlayerPosition(board, newPos, getOpponent(piece))) // capturing
 			return true;
 	}
 	if (rowDiff == 2 && !colDiff && isEmptyPosition(board, newPos)
@@ -161,15 +384,10 @@ static bool isValidMovePawn(ChessBoard* board, ChessPiecePosition pos,
  * NOTE: Doesn't check for king threats.
  */
 static bool isValidMoveBishop(ChessBoard* board, ChessPiecePosition pos,
-		ChessPiecePosition newPos, int rowDiff, int colDiff) {
-	// Checks if the direction is diagonal
-	if (rowDiff * rowDiff != colDiff * colDiff)
-		return false;
-
-	// Check diagonal direction
-	int vDirection = rowDiff > 0 ? 1 : -1;
-	int hDirection = colDiff > 0 ? 1 : -1;
-	return tryMoveToPosition(board, pos, newPos, vDirection, hDirection);
+		ChessPiecePosition newPos) {
+	return chessMoveGetBishopAttacks(chessGamePositionToSquare(pos),
+			chessGameGetOccupied(board))
+			& chessBitboardSquare(chessGamePositionToSquare(newPos));
 }
 
 /**
@@ -194,19 +412,10 @@ static bool isValidMoveKnight(int rowDiff, int colDiff) {
  * NOTE: Doesn't check for king threats.
  */
 static bool isValidMoveRook(ChessBoard* board, ChessPiecePosition pos,
-		ChessPiecePosition newPos, int rowDiff, int colDiff) {
-	// Checks if the direction is horizontal/vertical.
-	// Using logical NXOR trick to see if exactly one axis diff == 0
-	if (!(!rowDiff != !colDiff))
-		return false;
-
-	// Get diagonal direction
-	int vDirection = 0, hDirection = 0;
-	if (rowDiff)
-		vDirection = rowDiff > 0 ? 1 : -1;
-	else
-		hDirection = colDiff > 0 ? 1 : -1;
-	return tryMoveToPosition(board, pos, newPos, vDirection, hDirection);
+		ChessPiecePosition newPos) {
+	return chessMoveGetRookAttacks(chessGamePositionToSquare(pos),
+			chessGameGetOccupied(board))
+			& chessBitboardSquare(chessGamePositionToSquare(newPos));
 }
 
 /**
@@ -214,9 +423,9 @@ static bool isValidMoveRook(ChessBoard* board, ChessPiecePosition pos,
  * NOTE: Doesn't check for king threats.
  */
 static bool isValidMoveQueen(ChessBoard* board, ChessPiecePosition pos,
-		ChessPiecePosition newPos, int rowDiff, int colDiff) {
-	return isValidMoveRook(board, pos, newPos, rowDiff, colDiff)
-			|| isValidMoveBishop(board, pos, newPos, rowDiff, colDiff);
+		ChessPiecePosition newPos) {
+	return isValidMoveRook(board, pos, newPos)
+			|| isValidMoveBishop(board, pos, newPos);
 }
 
 /**
@@ -232,39 +441,39 @@ static bool isValidMoveKing(int rowDiff, int colDiff) {
  * Add all pawn moves, using chess rules.
  * NOTE: Doesn't check for king threats.
  */
-static void addMovesPawn(ArrayList* arr, ChessBoard* board,
+static void addMovesPawn(ChessMoveBuffer* buffer, ChessBoard* board,
 		ChessPiecePosition pos) {
 	int vDir =
 			chessGameGetPieceByPosition(board, pos).player == CHESS_WHITE_PLAYER ?
 					1 : -1;
 	// Check all possible pawn moves
 	// regular move
-	tryAddRelativePosition(arr, board, pos, vDir, 0);
+	tryAddRelativePosition(buffer, board, pos, vDir, 0);
 	// capture on left and right side
-	tryAddRelativePosition(arr, board, pos, vDir, -1);
-	tryAddRelativePosition(arr, board, pos, vDir, 1);
+	tryAddRelativePosition(buffer, board, pos, vDir, -1);
+	tryAddRelativePosition(buffer, board, pos, vDir, 1);
 	// special move at start
-	tryAddRelativePosition(arr, board, pos, 2 * vDir, 0);
+	tryAddRelativePosition(buffer, board, pos, 2 * vDir, 0);
 }
 
 /**
  * Add all bishop moves, using chess rules.
  * NOTE: Doesn't check for king threats.
  */
-static void addMovesBishop(ArrayList* arr, ChessBoard* board,
+static void addMovesBishop(ChessMoveBuffer* buffer, ChessBoard* board,
 		ChessPiecePosition pos) {
 	// Add all moves in the 4 diagonal directions
-	addMovesInDirection(arr, board, pos, 1, 1);
-	addMovesInDirection(arr, board, pos, -1, 1);
-	addMovesInDirection(arr, board, pos, 1, -1);
-	addMovesInDirection(arr, board, pos, -1, -1);
+	ChessBitboard attacks = chessMoveGetBishopAttacks(
+			chessGamePositionToSquare(pos), chessGameGetOccupied(board));
+	addMovesToTargets(buffer, board, pos, getSliderTargets(board, pos, attacks),
+			bishopDirections, bishopRays);
 }
 
 /**
  * Add all knight moves, using chess rules.
  * NOTE: Doesn't check for king threats.
  */
-static void addMovesKnight(ArrayList* arr, ChessBoard* board,
+static void addMovesKnight(ChessMoveBuffer* buffer, ChessBoard* board,
 		ChessPiecePosition pos) {
 	// Checks all possible knight moves (L shape)
 	for (int rAdd = -2; rAdd <= 2; rAdd++) {
@@ -272,8 +481,8 @@ static void addMovesKnight(ArrayList* arr, ChessBoard* board,
 			continue;
 		// if rowAdd = -1 or 1, colAdd = -2, else colAdd = -1
 		int cAdd = rAdd * rAdd == 1 ? -2 : -1;
-		tryAddRelativePosition(arr, board, pos, rAdd, cAdd);
-		tryAddRelativePosition(arr, board, pos, rAdd, -cAdd);
+		tryAddRelativePosition(buffer, board, pos, rAdd, cAdd);
+		tryAddRelativePosition(buffer, board, pos, rAdd, -cAdd);
 	}
 }
 
@@ -281,35 +490,160 @@ static void addMovesKnight(ArrayList* arr, ChessBoard* board,
  * Add all rook moves, using chess rules.
  * NOTE: Doesn't check for king threats.
  */
-static void addMovesRook(ArrayList* arr, ChessBoard* board,
+static void addMovesRook(ChessMoveBuffer* buffer, ChessBoard* board,
 		ChessPiecePosition pos) {
 	// Add all moves in the 4 horizontal/vertical directions
-	addMovesInDirection(arr, board, pos, 1, 0);
-	addMovesInDirection(arr, board, pos, -1, 0);
-	addMovesInDirection(arr, board, pos, 0, 1);
-	addMovesInDirection(arr, board, pos, 0, -1);
+	ChessBitboard attacks = chessMoveGetRookAttacks(
+			chessGamePositionToSquare(pos), chessGameGetOccupied(board));
+	addMovesToTargets(buffer, board, pos, getSliderTargets(board, pos, attacks),
+			rookDirections, rookRays);
 }
 
 /**
  * Add all queen moves, using chess rules.
  * NOTE: Doesn't check for king threats.
  */
-static void addMovesQueen(ArrayList* arr, ChessBoard* board,
+static void addMovesQueen(ChessMoveBuffer* buffer, ChessBoard* board,
 		ChessPiecePosition pos) {
-	addMovesBishop(arr, board, pos);
-	addMovesRook(arr, board, pos);
+	// Add the diagonal moves first, then the horizontal/vertical moves
+	ChessBitboard targets = getSliderTargets(board, pos,
+			chessMoveGetQueenAttacks(chessGamePositionToSquare(pos),
+					chessGameGetOccupied(board)));
+	addMovesToTargets(buffer, board, pos, targets, bishopDirections,
+			bishopRays);
+	addMovesToTargets(buffer, board, pos, targets, rookDirections, rookRays);
 }
 
 /**
  * Add all king moves, using chess rules.
  * NOTE: Doesn't check for king threats.
  */
-static void addMovesKing(ArrayList* arr, ChessBoard* board,
+static void addMovesKing(ChessMoveBuffer* buffer, ChessBoard* board,
 		ChessPiecePosition pos) {
 	// Checks all possible king moves (at most 1 step in each axis)
 	for (int rAdd = -1; rAdd <= 1; rAdd++)
 		for (int cAdd = -1; cAdd <= 1; cAdd++)
-			tryAddRelativePosition(arr, board, pos, rAdd, cAdd);
+			tryAddRelativePosition(buffer, board, pos, rAdd, cAdd);
+}
+
+/**
+ * Initializes the precomputed attack tables used for move generation.
+ * Must be called before any other function of this module, calling it more
+ * than once does nothing.
+ */
+void chessMoveInitAttackTables() {
+	if (attackTablesInitialized)
+		return;
+	ChessBitboard* bishopNext = bishopTable;
+	ChessBitboard* rookNext = rookTable;
+	for (int square = 0; square < CHESS_N_SQUARES; square++) {
+		bishopMagics[square].attacks = bishopNext;
+		initMagicEntry(&bishopMagics[square], square, bishopDirections);
+		bishopNext += (ChessBitboard) 1 << (CHESS_N_SQUARES
+				- bishopMagics[square].shift);
+		rookMagics[square].attacks = rookNext;
+		initMagicEntry(&rookMagics[square], square, rookDirections);
+		rookNext += (ChessBitboard) 1 << (CHESS_N_SQUARES
+				- rookMagics[square].shift);
+		initStepAttacks(square);
+		initRays(square);
+	}
+	for (int square = 0; square < CHESS_N_SQUARES; square++)
+		initLines(square);
+	attackTablesInitialized = true;
+}
+
+/**
+ * Gets all the squares a bishop in square attacks, given the occupied squares.
+ * The attacked squares include the first blocker in each direction.
+ */
+ChessBitboard chessMoveGetBishopAttacks(int square, ChessBitboard occupied) {
+	return getMagicAttacks(&bishopMagics[square], occupied);
+}
+
+/**
+ * Gets all the squares a rook in square attacks, given the occupied squares.
+ * The attacked squares include the first blocker in each direction.
+ */
+ChessBitboard chessMoveGetRookAttacks(int square, ChessBitboard occupied) {
+	return getMagicAttacks(&rookMagics[square], occupied);
+}
+
+/**
+ * Gets all the squares a queen in square attacks, given the occupied squares.
+ * The attacked squares include the first blocker in each direction.
+ */
+ChessBitboard chessMoveGetQueenAttacks(int square, ChessBitboard occupied) {
+	return getMagicAttacks(&bishopMagics[square], occupied)
+			| getMagicAttacks(&rookMagics[square], occupied);
+}
+
+/**
+ * Gets all the squares a knight in square attacks.
+ */
+ChessBitboard chessMoveGetKnightAttacks(int square) {
+	return knightAttacks[square];
+}
+
+/**
+ * Gets all the squares a king in square attacks.
+ */
+ChessBitboard chessMoveGetKingAttacks(int square) {
+	return kingAttacks[square];
+}
+
+/**
+ * Gets all the squares a pawn of the given player in square attacks, meaning
+ * the squares it can capture on.
+ */
+ChessBitboard chessMoveGetPawnAttacks(int square, int player) {
+	return pawnAttacks[player][square];
+}
+
+/**
+ * Gets the squares strictly between the two squares if they are on the same
+ * row, column or diagonal. Otherwise, returns an empty bitboard.
+ */
+ChessBitboard chessMoveGetBetween(int square1, int square2) {
+	return betweenSquares[square1][square2];
+}
+
+/**
+ * Gets the entire row, column or diagonal going through the two squares.
+ * If they aren't on the same line, returns an empty bitboard.
+ */
+ChessBitboard chessMoveGetLine(int square1, int square2) {
+	return lineSquares[square1][square2];
+}
+
+/**
+ * Gets the pieces of both players which attack square, given the occupied
+ * squares. The pieces are taken from the board, the occupied squares are given
+ * separately so pieces can be removed, e.g. to see through a moving king.
+ */
+ChessBitboard chessMoveGetAttackers(ChessBoard* board, int square,
+		ChessBitboard occupied) {
+	ChessBitboard (*pieces)[CHESS_N_PIECE_TYPES] = board->pieces;
+	ChessBitboard bishops = pieces[CHESS_WHITE_PLAYER][CHESS_PIECE_BISHOP]
+			| pieces[CHESS_BLACK_PLAYER][CHESS_PIECE_BISHOP]
+			| pieces[CHESS_WHITE_PLAYER][CHESS_PIECE_QUEEN]
+			| pieces[CHESS_BLACK_PLAYER][CHESS_PIECE_QUEEN];
+	ChessBitboard rooks = pieces[CHESS_WHITE_PLAYER][CHESS_PIECE_ROOK]
+			| pieces[CHESS_BLACK_PLAYER][CHESS_PIECE_ROOK]
+			| pieces[CHESS_WHITE_PLAYER][CHESS_PIECE_QUEEN]
+			| pieces[CHESS_BLACK_PLAYER][CHESS_PIECE_QUEEN];
+	return (pawnAttacks[CHESS_BLACK_PLAYER][square]
+			& pieces[CHESS_WHITE_PLAYER][CHESS_PIECE_PAWN])
+			| (pawnAttacks[CHESS_WHITE_PLAYER][square]
+					& pieces[CHESS_BLACK_PLAYER][CHESS_PIECE_PAWN])
+			| (knightAttacks[square]
+					& (pieces[CHESS_WHITE_PLAYER][CHESS_PIECE_KNIGHT]
+							| pieces[CHESS_BLACK_PLAYER][CHESS_PIECE_KNIGHT]))
+			| (kingAttacks[square]
+					& (pieces[CHESS_WHITE_PLAYER][CHESS_PIECE_KING]
+							| pieces[CHESS_BLACK_PLAYER][CHESS_PIECE_KING]))
+			| (chessMoveGetBishopAttacks(square, occupied) & bishops)
+			| (chessMoveGetRookAttacks(square, occupied) & rooks);
 }
 
 /**
@@ -323,10 +657,10 @@ static void addMovesKing(ArrayList* arr, ChessBoard* board,
 		return false;
 
 	ChessPiece piece = chessGameGetPieceByPosition(board, pos);
-	ChessPiece newPosPiece = chessGameGetPieceByPosition(board, newPos);
-	// Can't move to the same position or a position with a piece you own.
-	if (chessGameIsPositionEquals(pos, newPos)
-			|| piece.player == newPosPiece.player)
+	// Can't move from an empty position, to the same position or to a
+	// position with a piece you own.
+	if (piece.type == CHESS_PIECE_EMPTY
+			|| isPlayerPosition(board, newPos, piece.player))
 		return false;
 
 	int rowDiff = newPos.row - pos.row;
@@ -337,16 +671,16 @@ static void addMovesKing(ArrayList* arr, ChessBoard* board,
 		res = isValidMovePawn(board, pos, newPos, rowDiff, colDiff);
 		break;
 	case CHESS_PIECE_BISHOP:
-		res = isValidMoveBishop(board, pos, newPos, rowDiff, colDiff);
+		res = isValidMoveBishop(board, pos, newPos);
 		break;
 	case CHESS_PIECE_KNIGHT:
 		res = isValidMoveKnight(rowDiff, colDiff);
 		break;
 	case CHESS_PIECE_ROOK:
-		res = isValidMoveRook(board, pos, newPos, rowDiff, colDiff);
+		res = isValidMoveRook(board, pos, newPos);
 		break;
 	case CHESS_PIECE_QUEEN:
-		res = isValidMoveQueen(board, pos, newPos, rowDiff, colDiff);
+		res = isValidMoveQueen(board, pos, newPos);
 		break;
 	case CHESS_PIECE_KING:
 		res = isValidMoveKing(rowDiff, colDiff);
@@ -358,41 +692,90 @@ static void addMovesKing(ArrayList* arr, ChessBoard* board,
 }
 
 /**
- * Get all valid moves of a piece in pos.
- * Returns NULL if arrayList fails or the position is empty\invalid.
+ * Adds all valid moves of a piece in pos to the end of the buffer.
+ * Does nothing if the position is empty\invalid.
  * NOTE: Doesn't check for king threats.
  * NOTE2: Doesn't update isThreatened field. It should be updated in ChessGame.
  */
-ArrayList* chessMoveGetMoves(ChessBoard* board, ChessPiecePosition pos) {
+void chessMoveGenerateMoves(ChessBoard* board, ChessPiecePosition pos,
+		ChessMoveBuffer* buffer) {
 	//Validate parameters
-	if (board == NULL || !chessGameIsValidPosition(pos))
-		return NULL ;
+	if (board == NULL || buffer == NULL || !chessGameIsValidPosition(pos))
+		return;
 
-	ChessPiece piece = chessGameGetPieceByPosition(board, pos);
-	ArrayList* arr = arrayListCreate(getArraySizeByPieceType(piece));
-	if (arr == NULL )
-		return NULL ;
-	switch (piece.type) {
+	switch (chessGameGetPieceByPosition(board, pos).type) {
 	case CHESS_PIECE_PAWN:
-		addMovesPawn(arr, board, pos);
+		addMovesPawn(buffer, board, pos);
 		break;
 	case CHESS_PIECE_BISHOP:
-		addMovesBishop(arr, board, pos);
+		addMovesBishop(buffer, board, pos);
 		break;
 	case CHESS_PIECE_KNIGHT:
-		addMovesKnight(arr, board, pos);
+		addMovesKnight(buffer, board, pos);
 		break;
 	case CHESS_PIECE_ROOK:
-		addMovesRook(arr, board, pos);
+		addMovesRook(buffer, board, pos);
 		break;
 	case CHESS_PIECE_QUEEN:
-		addMovesQueen(arr, board, pos);
+		addMovesQueen(buffer, board, pos);
 		break;
 	case CHESS_PIECE_KING:
-		addMovesKing(arr, board, pos);
+		addMovesKing(buffer, board, pos);
 		break;
 	default:
 		break;
 	}
+}
+
+/**
+ * Adds all valid moves of the player's pieces to the end of the buffer.
+ * The moves are ordered by the position of the moving piece, row by row.
+ * NOTE: Doesn't check for king threats.
+ * NOTE2: Doesn't update isThreatened field. It should be updated in ChessGame.
+ */
+void chessMoveGenerateAllMoves(ChessBoard* board, int player,
+		ChessMoveBuffer* buffer) {
+	//Validate parameters
+	if (board == NULL || buffer == NULL || player < 0
+			|| player >= CHESS_N_PLAYERS)
+		return;
+
+	ChessBitboard pieces = board->occupied[player];
+	while (pieces) {
+		int square = chessBitboardPopFirstSquare(&pieces);
+		chessMoveGenerateMoves(board, chessGameSquareToPosition(square),
+				buffer);
+	}
+}
+
+/**
+ * Get all valid moves of a piece in pos.
+ * Returns NULL if arrayList fails or the position is empty\invalid.
+ * NOTE: Doesn't check for king threats.
+ * NOTE2: Doesn't update isThreatened field. It should be updated in ChessGame.
+ */
+ArrayList* chessMoveGetMoves(ChessBoard* board, ChessPiecePosition pos) {
+	//Validate parameters
+	if (board == NULL || !chessGameIsValidPosition(pos))
+		return NULL ;
+
+	ChessMoveBuffer buffer;
+	buffer.size = 0;
+	chessMoveGenerateMoves(board, pos, &buffer);
+	return chessMoveBufferToArrayList(&buffer,
+			chessMoveGetMaxMoves(chessGameGetPieceByPosition(board, pos)));
+}
+
+/**
+ * Creates an array list with a copy of the buffer's moves.
+ * Returns NULL if arrayList fails or maxSize <= 0.
+ */
+ArrayList* chessMoveBufferToArrayList(ChessMoveBuffer* buffer, int maxSize) {
+	ArrayList* arr = arrayListCreate(maxSize);
+	if (arr == NULL )
+		return NULL ;
+	for (int i = 0; i < buffer->size && i < maxSize; i++)
+		arr->elements[i] = buffer->moves[i];
+	arr->actualSize = buffer->size < maxSize ? buffer->size : maxSize;
 	return arr;
 }
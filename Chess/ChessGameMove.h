@@ -13,6 +13,82 @@
 #define WHITE_PAWN_ROW 1
 #define BLACK_PAWN_ROW 6
 
+// The maximum number of moves in any chess position. It also bounds the moves
+// which threaten the king: without promotions a player has at most the pieces
+// of the starting position, which LoadGame checks too, so at most 137 moves.
+#define CHESS_MAX_MOVES 218
+
+/**
+ * Type for a fixed capacity buffer of moves. The buffer is owned by the caller,
+ * usually on the stack, so generating moves into it doesn't allocate memory.
+ * Set size to 0 before the first use.
+ */
+typedef struct chess_move_buffer_t {
+	ChessMove moves[CHESS_MAX_MOVES];
+	int size;
+} ChessMoveBuffer;
+
+/**
+ * Initializes the precomputed attack tables used for move generation.
+ * Must be called before any other function of this module, calling it more
+ * than once does nothing.
+ */
+void chessMoveInitAttackTables();
+
+/**
+ * Gets all the squares a bishop in square attacks, given the occupied squares.
+ * The attacked squares include the first blocker in each direction.
+ */
+ChessBitboard chessMoveGetBishopAttacks(int square, ChessBitboard occupied);
+
+/**
+ * Gets all the squares a rook in square attacks, given the occupied squares.
+ * The attacked squares include the first blocker in each direction.
+ */
+ChessBitboard chessMoveGetRookAttacks(int square, ChessBitboard occupied);
+
+/**
+ * Gets all the squares a queen in square attacks, given the occupied squares.
+ * The attacked squares include the first blocker in each direction.
+ */
+ChessBitboard chessMoveGetQueenAttacks(int square, ChessBitboard occupied);
+
+/**
+ * Gets all the squares a knight in square attacks.
+ */
+ChessBitboard chessMoveGetKnightAttacks(int square);
+
+/**
+ * Gets all the squares a king in square attacks.
+ */
+ChessBitboard chessMoveGetKingAttacks(int square);
+
+/**
+ * Gets all the squares a pawn of the given player in square attacks, meaning
+ * the squares it can capture on.
+ */
+ChessBitboard chessMoveGetPawnAttacks(int square, int player);
+
+/**
+ * Gets the squares strictly between the two squares if they are on the same
+ * row, column or diagonal. Otherwise, returns an empty bitboard.
+ */
+ChessBitboard chessMoveGetBetween(int square1, int square2);
+
+/**
+ * Gets the entire row, column or diagonal going through the two squares.
+ * If they aren't on the same line, returns an empty bitboard.
+ */
+ChessBitboard chessMoveGetLine(int square1, int square2);
+
+/**
+ * Gets the pieces of both players which attack square, given the occupied
+ * squares. The pieces are taken from the board, the occupied squares are given
+ * separately so pieces can be removed, e.g. to see through a moving king.
+ */
+ChessBitboard chessMoveGetAttackers(ChessBoard* board, int square,
+		ChessBitboard occupied);
+
 /**
  * Validate movement from pos to newPos, split to cases by pos's piece type
  * NOTE: Doesn't check for king threats.
@@ -20,6 +96,24 @@
 bool chessMoveIsValidMove(ChessBoard* board, ChessPiecePosition pos,
 		ChessPiecePosition newPos);
 
+/**
+ * Adds all valid moves of a piece in pos to the end of the buffer.
+ * Does nothing if the position is empty\invalid.
+ * NOTE: Doesn't check for king threats.
+ * NOTE2: Doesn't update isThreatened field. It should be updated in ChessGame.
+ */
+void chessMoveGenerateMoves(ChessBoard* board, ChessPiecePosition pos,
+		ChessMoveBuffer* buffer);
+
+/**
+ * Adds all valid moves of the player's pieces to the end of the buffer.
+ * The moves are ordered by the position of the moving piece, row by row.
+ * NOTE: Doesn't check for king threats.
+ * NOTE2: Doesn't update isThreatened field. It should be updated in ChessGame.
+ */
+void chessMoveGenerateAllMoves(ChessBoard* board, int player,
+		ChessMoveBuffer* buffer);
+
 /**
  * Get all valid moves of a piece in pos.
  * Returns NULL if arrayList fails or the position is empty\invalid.
@@ -28,4 +122,15 @@ bool chessMoveIsValidMove(ChessBoard* board, ChessPiecePosition pos,
  */
 ArrayList* chessMoveGetMoves(ChessBoard* board, ChessPiecePosition pos);
 
+/**
+ * Gets the maximum number of moves a piece of that type can have.
+ */
+int chessMoveGetMaxMoves(ChessPiece piece);
+
+/**
+ * Creates an array list with a copy of the buffer's moves.
+ * Returns NULL if arrayList fails or maxSize <= 0.
+ */
+ArrayList* chessMoveBufferToArrayList(ChessMoveBuffer* buffer, int maxSize);
+
 #endif /* CHESSGAMEMOVE_H_ */
@@ -10,6 +10,9 @@
 #include <stdlib.h>
 
 #define HISTORY_SIZE 6
+#define LOAD_TEST_FILE "load_test.txt"
+#define EMPTY_SYMBOL '_'
+#define WHITE_QUEEN_SYMBOL 'q'
 /*
  static bool ChessGameValidMoveTest() {
  ChessGame* res = ChessGameCreate(HISTORY_SIZE);
@@ -328,6 +331,173 @@ static bool ChessGameLoadGameTest(){
 }
 */
 
+static CHESS_GAME_MESSAGE playMove(ChessGame* game, int row, int column,
+		int nextRow, int nextColumn) {
+	return chessGameSetMove(game,
+			(ChessPiecePosition ) { .row = row, .column = column },
+			(ChessPiecePosition ) { .row = nextRow, .column = nextColumn });
+}
+
+static void clearBoard(ChessGame* game) {
+	for (int i = 0; i < CHESS_N_ROWS; i++)
+		for (int j = 0; j < CHESS_N_COLUMNS; j++)
+			chessGameSetPiece(game,
+					(ChessPiecePosition ) { .row = i, .column = j },
+					chessGameCharToChessPieceConverter(EMPTY_SYMBOL));
+}
+
+static bool ChessGameHasLegalMoveTest() {
+	ChessGame* res = chessGameCreate();
+	ASSERT_TRUE(res!=NULL);
+	ASSERT_TRUE(chessGameHasLegalMove(res));
+
+	//Fool's mate
+	ASSERT_TRUE(playMove(res, 1, 5, 2, 5) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(playMove(res, 6, 4, 4, 4) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(playMove(res, 1, 6, 3, 6) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(playMove(res, 7, 3, 3, 7) == CHESS_GAME_SUCCESS);
+	ASSERT_FALSE(chessGameHasLegalMove(res));
+	ASSERT_TRUE(chessGameGetCurrentState(res) == CHESS_GAME_CHECKMATE);
+
+	//Without the bishop in <1,F> the king can step out of the check
+	chessGameSetPiece(res, (ChessPiecePosition ) { .row = 0, .column = 5 },
+			chessGameCharToChessPieceConverter(EMPTY_SYMBOL));
+	chessGameUpdateIsCheck(res);
+	ASSERT_TRUE(chessGameHasLegalMove(res));
+	ASSERT_TRUE(chessGameGetCurrentState(res) == CHESS_GAME_CHECK);
+	chessGameDestroy(res);
+
+	//Stalemate, black king in <8,H> and white queen in <6,G>
+	res = chessGameCreate();
+	ASSERT_TRUE(res!=NULL);
+	clearBoard(res);
+	chessGameSetPiece(res, (ChessPiecePosition ) { .row = 0, .column = 0 },
+			chessGameCharToChessPieceConverter(WHITE_KING_SYMBOL));
+	chessGameSetPiece(res, (ChessPiecePosition ) { .row = 5, .column = 6 },
+			chessGameCharToChessPieceConverter(WHITE_QUEEN_SYMBOL));
+	chessGameSetPiece(res, (ChessPiecePosition ) { .row = 7, .column = 7 },
+			chessGameCharToChessPieceConverter(BLACK_KING_SYMBOL));
+	chessGameSetCurrentPlayer(res, CHESS_BLACK_PLAYER);
+	chessGameUpdateIsCheck(res);
+	ASSERT_FALSE(chessGameHasLegalMove(res));
+	ASSERT_TRUE(chessGameGetCurrentState(res) == CHESS_GAME_DRAW);
+	chessGameDestroy(res);
+	return true;
+}
+
+static bool ChessGameLoadCheckTest() {
+	GameSettings* settings = gameSettingsCreate();
+	ASSERT_TRUE(settings!=NULL);
+	//Check, the pawn in <7,G> can block it
+	ChessGame* game = settings->chessGame;
+	ASSERT_TRUE(playMove(game, 1, 4, 3, 4) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(playMove(game, 6, 5, 4, 5) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(playMove(game, 0, 3, 4, 7) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(
+			gameSettingsSave(LOAD_TEST_FILE, settings)
+					== GAME_SETTINGS_SAVE_GAME_SUCCESS);
+	GameSettings* loaded = gameSettingsCreate();
+	ASSERT_TRUE(loaded!=NULL);
+	ASSERT_TRUE(
+			gameSettingsLoad(loaded, LOAD_TEST_FILE)
+					== GAME_SETTINGS_LOAD_FILE_SUCCESS);
+	ASSERT_TRUE(
+			chessGameGetCurrentState(loaded->chessGame) == CHESS_GAME_CHECK);
+	ASSERT_TRUE(
+			playMove(loaded->chessGame, 6, 0, 5, 0)
+					== CHESS_GAME_UNRESOLVED_THREATENED_KING);
+	ASSERT_TRUE(playMove(loaded->chessGame, 6, 6, 5, 6) == CHESS_GAME_SUCCESS);
+	gameSettingsDestroy(loaded);
+
+	//Mate, the pawn in <7,G> was pushed before the queen's move
+	ASSERT_TRUE(chessGameUndoMove(game) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(playMove(game, 0, 1, 2, 2) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(playMove(game, 6, 6, 4, 6) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(playMove(game, 0, 3, 4, 7) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(
+			gameSettingsSave(LOAD_TEST_FILE, settings)
+					== GAME_SETTINGS_SAVE_GAME_SUCCESS);
+	loaded = gameSettingsCreate();
+	ASSERT_TRUE(loaded!=NULL);
+	ASSERT_TRUE(
+			gameSettingsLoad(loaded, LOAD_TEST_FILE)
+					== GAME_SETTINGS_LOAD_FILE_SUCCESS);
+	ASSERT_TRUE(
+			chessGameGetCurrentState(loaded->chessGame)
+					== CHESS_GAME_CHECKMATE);
+	gameSettingsDestroy(loaded);
+	gameSettingsDestroy(settings);
+	remove(LOAD_TEST_FILE);
+	return true;
+}
+
+static bool isSameBoard(ChessGame* game, ChessGame* other) {
+	for (int i = 0; i < CHESS_N_ROWS; i++)
+		for (int j = 0; j < CHESS_N_COLUMNS; j++)
+			if (game->gameBoard.position[i][j].type
+					!= other->gameBoard.position[i][j].type
+					|| game->gameBoard.position[i][j].player
+							!= other->gameBoard.position[i][j].player)
+				return false;
+	return chessGameGetCurrentPlayer(game) == chessGameGetCurrentPlayer(other);
+}
+
+//Plays the first moves of an italian game, none of them repeats a position
+static bool playOpening(ChessGame* game, int numOfMoves) {
+	static const int moves[][4] = { { 1, 4, 3, 4 }, { 6, 4, 4, 4 },
+			{ 0, 6, 2, 5 }, { 7, 1, 5, 2 }, { 0, 5, 3, 2 }, { 7, 5, 4, 2 },
+			{ 1, 3, 2, 3 }, { 6, 3, 5, 3 } };
+	for (int i = 0; i < numOfMoves; i++)
+		if (playMove(game, moves[i][0], moves[i][1], moves[i][2], moves[i][3])
+				!= CHESS_GAME_SUCCESS)
+			return false;
+	return true;
+}
+
+static bool ChessGameHistoryOverflowTest() {
+	ChessGame* res = chessGameCreate();
+	ASSERT_TRUE(res!=NULL);
+	ChessGame* expected = chessGameCreate();
+	ASSERT_TRUE(expected!=NULL);
+	//Two moves more than the history keeps, the first two are dropped
+	ASSERT_TRUE(playOpening(res, HISTORY_SIZE + 2));
+	ASSERT_TRUE(playOpening(expected, 2));
+	for (int i = 0; i < HISTORY_SIZE; i++)
+		ASSERT_TRUE(chessGameUndoMove(res) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(chessGameIsHistoryEmpty(res));
+	ASSERT_TRUE(chessGameUndoMove(res) == CHESS_GAME_EMPTY_HISTORY);
+	ASSERT_TRUE(isSameBoard(res, expected));
+	chessGameDestroy(expected);
+	chessGameDestroy(res);
+	return true;
+}
+
+static bool ChessGameHistorySizeTest() {
+	ASSERT_TRUE(chessGameCreateWithHistorySize(0) == NULL);
+	ChessGame* res = chessGameCreateWithHistorySize(3);
+	ASSERT_TRUE(res!=NULL);
+	ChessGame* expected = chessGameCreate();
+	ASSERT_TRUE(expected!=NULL);
+	//The history wraps around twice
+	ASSERT_TRUE(playOpening(res, 8));
+	ASSERT_TRUE(playOpening(expected, 5));
+	ChessMove last = chessGameGetLastMove(res);
+	ASSERT_TRUE(last.previousPosition.row == 6);
+	ASSERT_TRUE(last.currentPosition.row == 5);
+	ASSERT_TRUE(last.currentPosition.column == 3);
+	for (int i = 0; i < 3; i++)
+		ASSERT_TRUE(chessGameUndoMove(res) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(chessGameUndoMove(res) == CHESS_GAME_EMPTY_HISTORY);
+	ASSERT_TRUE(isSameBoard(res, expected));
+	//The history is used again after the undos
+	ASSERT_TRUE(playMove(res, 7, 5, 4, 2) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(chessGameUndoMove(res) == CHESS_GAME_SUCCESS);
+	ASSERT_TRUE(isSameBoard(res, expected));
+	chessGameDestroy(expected);
+	chessGameDestroy(res);
+	return true;
+}
+
 int main1() {
 
 	//RUN_TEST(ChessGameBasicTest);
@@ -338,6 +508,10 @@ int main1() {
 	//printf("//GameLoad///\n");
 	//RUN_TEST(ChessGameLoadGameTest);
 	//RUN_TEST(ChessGameMinimaxTest);
+	RUN_TEST(ChessGameHasLegalMoveTest);
+	RUN_TEST(ChessGameLoadCheckTest);
+	RUN_TEST(ChessGameHistoryOverflowTest);
+	RUN_TEST(ChessGameHistorySizeTest);
 
 	/*
 	 RUN_TEST(ChessGameUndoMoveTest);
@@ -68,6 +68,8 @@ GameSettings* gameSettingsCreate() {
 		settings->maxDepth = DIFFICULTY_LEVEL_2_INT; //unsigned int
 		settings->userColor = CHESS_WHITE_PLAYER; //int
 	}
+	settings->searchTableSizeMB = DEFAULT_SEARCH_TABLE_SIZE_MB;
+	settings->searchTimeLimitMS = DEFAULT_SEARCH_TIME_LIMIT_MS;
 
 	return settings;
 }
@@ -213,6 +215,8 @@ GAME_SETTINGS_MESSAGE gameSettingsDefaulter(GameSettings* settings) {
 	settings->gameMode = ONE_PLAYER;
 	settings->maxDepth = DIFFICULTY_LEVEL_2_INT;
 	settings->userColor = CHESS_WHITE_PLAYER;
+	settings->searchTableSizeMB = DEFAULT_SEARCH_TABLE_SIZE_MB;
+	settings->searchTimeLimitMS = DEFAULT_SEARCH_TIME_LIMIT_MS;
 	return GAME_SETTINGS_DEFAULT_SUCCESS;
 }
 
@@ -45,6 +45,14 @@ typedef enum game_settings_message_t {
 #define DIFFICULTY_LEVEL_4_INT 4
 #define DIFFICULTY_LEVEL_5_INT 5
 
+/*
+ * Computer search definitions - the default transposition table size in
+ * megabytes and time limit in milliseconds, 0 means no time limit.
+ * No command changes them, they are set only by the program.
+ */
+#define DEFAULT_SEARCH_TABLE_SIZE_MB 8
+#define DEFAULT_SEARCH_TIME_LIMIT_MS 0
+
 /*
  typedef enum {
 	CHESS_DIFFICULTY_AMATEUR = 1,
@@ -87,6 +95,8 @@ typedef struct game_setting_t {
 	char gameMode;
 	int userColor; //relevant for 1-mode only
 	unsigned int maxDepth; //relevant for 1-mode only
+	unsigned int searchTableSizeMB; //relevant for 1-mode only, 0 for no table
+	unsigned int searchTimeLimitMS; //relevant for 1-mode only, 0 for no limit
 } GameSettings;
 
 
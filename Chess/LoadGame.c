@@ -7,20 +7,6 @@
 
 #define LINE_LENGTH 22
 
-/*
- * Updates the positions of the white and black kings in the game fields while loading the board.
- */
-static void checkKingPosition(ChessGame* chessGame, char symbol, int place,
-		int lineNumber) {
-	if (symbol == WHITE_KING_SYMBOL) {
-		chessGame->whiteKingPosition.row = lineNumber;
-		chessGame->whiteKingPosition.column = place;
-	} else if (symbol == BLACK_KING_SYMBOL) {
-		chessGame->blackKingPosition.row = lineNumber;
-		chessGame->blackKingPosition.column = place;
-	}
-}
-
 /*
  * Updates the difficulty level from a loaded file.
  */
@@ -62,11 +48,31 @@ static int loadPlayer(char* line) {
 
 }
 
+/*
+ * Checks that no player has more pieces of a type than a game starts with.
+ * There are no promotions, so a game can't reach such a board.
+ */
+static bool isValidBoard(ChessPiece board[CHESS_N_ROWS][CHESS_N_COLUMNS]) {
+	static const int maxPieces[CHESS_N_PIECE_TYPES] = { CHESS_N_COLUMNS, 2, 2,
+			2, 1, 1 };
+	int pieces[CHESS_N_PLAYERS][CHESS_N_PIECE_TYPES] = { { 0 } };
+	for (int i = 0; i < CHESS_N_ROWS; i++)
+		for (int j = 0; j < CHESS_N_COLUMNS; j++) {
+			ChessPiece piece = board[i][j];
+			if (piece.type != CHESS_PIECE_EMPTY
+					&& ++pieces[piece.player][piece.type] > maxPieces[piece.type])
+				return false;
+		}
+	return true;
+}
+
 /*
  * Updates the settings from a loaded file.
+ * The board is set only if all of its rows were read and it is valid.
  */
 static void loadSettings(GameSettings* settings, FILE* file) {
 	ChessGame* game = settings->chessGame;
+	ChessPiece board[CHESS_N_ROWS][CHESS_N_COLUMNS];
 	char line[LINE_LENGTH];
 	int lineNumber = CHESS_N_ROWS;
 	int player;
@@ -75,11 +81,11 @@ static void loadSettings(GameSettings* settings, FILE* file) {
 	int userColor = CHESS_WHITE_PLAYER;
 	int count = 0;
 	int place;
-	while (fgets(line, sizeof(line), file) != NULL ) {
+	while (lineNumber > 0 && fgets(line, sizeof(line), file) != NULL ) {
 		switch (count) {
 		case 0:
 			player = loadPlayer(line);
-			game->currentPlayer = player;
+			chessGameSetCurrentPlayer(game, player);
 			count++;
 			break;
 		case 1:
@@ -104,22 +110,23 @@ static void loadSettings(GameSettings* settings, FILE* file) {
 			break;
 		case 5:
 			place = 0;
-			if (lineNumber > 0) {
-				lineNumber--;
-				for (int pos = 3; pos < 18; pos = pos + 2) {
-					checkKingPosition(game, line[pos], place, lineNumber);
-					game->gameBoard.position[lineNumber][place] =
-							chessGameCharToChessPieceConverter(line[pos]);
-					place++;
-				}
-			} else
-				return;
+			lineNumber--;
+			for (int pos = 3; pos < 18; pos = pos + 2) {
+				board[lineNumber][place] = chessGameCharToChessPieceConverter(
+						line[pos]);
+				place++;
+			}
 		}
 	}
-	if (ferror(file)) {
+	if (ferror(file) || lineNumber > 0 || !isValidBoard(board)) {
 		hadFileFailure();
 		return;
 	}
+	for (int i = 0; i < CHESS_N_ROWS; i++)
+		for (int j = 0; j < CHESS_N_COLUMNS; j++)
+			chessGameSetPiece(game,
+					(ChessPiecePosition ) { .row = i, .column = j },
+					board[i][j]);
 	chessGameUpdateIsCheck(game);
 }
 
@@ -504,15 +504,15 @@ int handlingGameCommand(GameSettings* settings, CmdCommand* command) {
 				settings, command);
 		return 1;
 	case CMD_UNDO:
-		if (arrayListIsEmpty(settings->chessGame->history)) {
+		if (chessGameIsHistoryEmpty(settings->chessGame)) {
 			gameMessageToOutput(CHESS_GAME_EMPTY_HISTORY, settings);
 			return 0;
 		}
-		move = arrayListGetLast(settings->chessGame->history); //first move to undo
+		move = chessGameGetLastMove(settings->chessGame); //first move to undo
 		handleUndoCommand(settings, &move);
 		//second move to undo
-		if (!arrayListIsEmpty(settings->chessGame->history)) {
-			move = arrayListGetLast(settings->chessGame->history);
+		if (!chessGameIsHistoryEmpty(settings->chessGame)) {
+			move = chessGameGetLastMove(settings->chessGame);
 			handleUndoCommand(settings, &move);
 		}
 		chessGamePrintBoard(settings->chessGame, stdout);
@@ -622,20 +622,8 @@ int computerTurn(GameSettings* settings) {
 				columnIntToChar(move.previousPosition.column),
 				(move.currentPosition.row) + 1,
 				columnIntToChar(move.currentPosition.column));
-	message = chessGameGetCurrentState(settings->chessGame);
-	switch (message) {
-	case CHESS_GAME_NONE:
-		return 0;
-	case CHESS_GAME_CHECK:
-		return 0;
-	case CHESS_GAME_DRAW:
-		return 1;
-	case CHESS_GAME_CHECKMATE:
-		return 1;
-	default:
-		return 0;
-	}
-	return 0;
+	//checkmate or draw if the user has no legal move, the check state isn't needed here
+	return chessGameHasLegalMove(settings->chessGame) ? 0 : 1;
 }
 
 /*
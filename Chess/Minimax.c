@@ -1,5 +1,9 @@
+#define _POSIX_C_SOURCE 200112L
 #include <stdlib.h>
 #include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
 #include "Minimax.h"
 #include "ChessErrorHandler.h"
 
@@ -7,8 +11,88 @@
  * Special scores
  */
 #define DRAW_SCORE 0
-#define BLACK_CHECKMATE_SCORE -1000
-#define WHITE_CHECKMATE_SCORE 1000
+#define BLACK_CHECKMATE_SCORE -100000
+#define WHITE_CHECKMATE_SCORE 100000
+
+/*
+ * Transposition table definitions
+ */
+#define TT_BYTES_IN_MB (1024 * 1024)
+#define NO_SQUARE -1
+
+/*
+ * Move ordering scores. The best move from the previous iteration or the table
+ * goes first, then the captures which don't lose material ordered by most
+ * valuable victim / least valuable attacker, then the killer moves, the rest
+ * of the quiet moves by their history and last the captures which lose
+ * material.
+ */
+#define ORDER_FIRST_MOVE 1000000000
+#define ORDER_GOOD_CAPTURE 100000000
+#define ORDER_FIRST_KILLER 90000
+#define ORDER_SECOND_KILLER 80000
+#define ORDER_QUIET_MOVE 0
+#define ORDER_BAD_CAPTURE -100000000
+#define MVV_LVA_VICTIM_FACTOR (KING_SCORE + 1)
+
+/*
+ * Killer and history heuristics definitions. The history of all moves is
+ * halved once a move's history reaches the killers' ordering score.
+ */
+#define MAX_SEARCH_DEPTH 64
+#define NUM_OF_KILLERS 2
+#define MAX_HISTORY_SCORE (ORDER_SECOND_KILLER - 1)
+
+/*
+ * The most a capture can gain beyond the captured piece's score, used to skip
+ * captures which can't reach the bound in the quiescence search.
+ */
+#define DELTA_MARGIN PAWN_SCORE
+
+/*
+ * Null move pruning definitions. A player who could pass the turn and still
+ * fail high is assumed to fail high with a real move as well, judging by a
+ * search reduced by NULL_MOVE_REDUCTION plies.
+ */
+#define NULL_MOVE_MIN_DEPTH 3
+#define NULL_MOVE_REDUCTION 2
+
+/*
+ * Late move reductions definitions. Quiet moves ordered after the first
+ * LMR_MIN_MOVES moves are searched LMR_REDUCTION plies shallower, and searched
+ * again to the full depth if they turn out better than the bound.
+ */
+#define LMR_MIN_DEPTH 3
+#define LMR_MIN_MOVES 3
+#define LMR_REDUCTION 1
+
+/*
+ * Futility pruning and razoring definitions, for nodes up to the given number
+ * of plies from the max depth. The margins are per ply left. Quiet moves which
+ * can't bring the board score up to the bound even with the futility margin are
+ * skipped, and nodes whose board score is below the bound by more than the
+ * razoring margin are only searched by the quiescence search.
+ */
+#define FUTILITY_MAX_DEPTH 2
+#define FUTILITY_MARGIN (2 * PAWN_SCORE)
+#define RAZOR_MAX_DEPTH 2
+#define RAZOR_MARGIN (3 * PAWN_SCORE)
+
+/*
+ * Maximum number of captures on a single square
+ */
+#define MAX_EXCHANGE_LENGTH 32
+
+/*
+ * The initial distance of the root's window from the previous depth's score.
+ * The window is doubled while the score falls outside of it.
+ */
+#define ASPIRATION_WINDOW (2 * PAWN_SCORE)
+
+/*
+ * Number of nodes searched between checks of the time limit
+ */
+#define TIME_CHECK_NODES 1024
 
 /*
  * Struct to represent tree node in the minimax tree
@@ -20,50 +104,144 @@ typedef struct tree_node_t {
 } TreeNode;
 
 /*
- * Defines the score for each piece.
- */
-static int pieceTypeToScore(CHESS_PIECE_TYPE type) {
-	int score = 0;
-	switch (type) {
-	case CHESS_PIECE_PAWN:
-		score = 1;
-		break;
-	case CHESS_PIECE_BISHOP:
-		score = 3;
-		break;
-	case CHESS_PIECE_KNIGHT:
-		score = 3;
-		break;
-	case CHESS_PIECE_ROOK:
-		score = 5;
-		break;
-	case CHESS_PIECE_QUEEN:
-		score = 9;
-		break;
-	case CHESS_PIECE_KING:
-		score = 100;
-		break;
-	case CHESS_PIECE_EMPTY:
-		score = 0;
-		break;
-	}
-	return (score);
-}
-
-/*
- * Calculated the board score according to the pieces on it.
- */
-static int scoringFunction(ChessBoard* gameBoard) {
-	int score = 0;
-	for (int i = 0; i < CHESS_N_ROWS; i++) {
-		for (int j = 0; j < CHESS_N_COLUMNS; j++) {
-			if (gameBoard->position[i][j].player)
-				score += pieceTypeToScore(gameBoard->position[i][j].type);
-			else
-				score -= pieceTypeToScore(gameBoard->position[i][j].type);
-		}
+ * The kind of score kept in a transposition table entry. A search which
+ * returned a score outside of its alpha-beta window only gives a bound.
+ */
+typedef enum tt_bound_t {
+	TT_BOUND_EXACT, TT_BOUND_LOWER, TT_BOUND_UPPER,
+} TT_BOUND;
+
+/*
+ * Struct to represent a searched position in the transposition table.
+ * depth is the number of plies searched below the position, the best move is
+ * kept by its squares.
+ */
+typedef struct tt_entry_t {
+	uint64_t key;
+	int score;
+	signed char depth;
+	signed char bound;
+	signed char bestFrom;
+	signed char bestTo;
+} TTEntry;
+
+/*
+ * Struct to represent a move by its squares.
+ */
+typedef struct move_squares_t {
+	signed char from;
+	signed char to;
+} MoveSquares;
+
+typedef struct transposition_table_t {
+	TTEntry* entries;
+	uint64_t mask;
+} TranspositionTable;
+
+/*
+ * The state shared by all the nodes of a single search.
+ * maxDepth is the depth of the current iteration. Reduced searches count the
+ * skipped plies in their depth, so their nodes reach maxDepth earlier.
+ * isAfterNullMove is set for the node searched after a null move.
+ * The search of an iteration is stopped once isTimeUp is set, and its result
+ * is ignored.
+ */
+typedef struct search_context_t {
+	ChessGame* game;
+	int maxDepth;
+	TranspositionTable table;
+	bool hasPreviousMove;
+	ChessMove previousMove;
+	MoveSquares killers[MAX_SEARCH_DEPTH][NUM_OF_KILLERS];
+	int history[CHESS_N_SQUARES][CHESS_N_SQUARES];
+	bool isAfterNullMove;
+	bool hasDeadline;
+	double deadline;
+	bool isTimeUp;
+	unsigned long nodes;
+} SearchContext;
+
+/*
+ * Creates an empty table with the largest power of 2 entries fitting in
+ * sizeMB, or no entries if sizeMB is 0.
+ * @return
+ * false if a memory allocation failure occurred, true otherwise.
+ */
+static bool transpositionTableCreate(TranspositionTable* table,
+		unsigned int sizeMB) {
+	uint64_t numOfEntries = 1;
+	uint64_t maxEntries = (uint64_t) sizeMB * TT_BYTES_IN_MB / sizeof(TTEntry);
+	table->entries = NULL;
+	table->mask = 0;
+	if (sizeMB == 0)
+		return true;
+	while (numOfEntries * 2 <= maxEntries)
+		numOfEntries *= 2;
+	table->entries = calloc(numOfEntries, sizeof(TTEntry));
+	if (table->entries == NULL) {
+		hadMemoryFailure();
+		return false;
 	}
-	return score;
+	table->mask = numOfEntries - 1;
+	return true;
+}
+
+/*
+ * Gets the table's entry of the position with the given key.
+ * @return
+ * NULL if the position isn't in the table.
+ */
+static TTEntry* transpositionTableProbe(TranspositionTable* table,
+		uint64_t key) {
+	if (table->entries == NULL)
+		return NULL;
+	TTEntry* entry = &(table->entries[key & table->mask]);
+	return entry->key == key && entry->depth > 0 ? entry : NULL;
+}
+
+/*
+ * Stores the result of a search, replacing the previous entry in its slot.
+ * The bound is derived from the alpha-beta window the search was given.
+ */
+static void transpositionTableStore(TranspositionTable* table, uint64_t key,
+		int depth, int score, int alpha, int beta, ChessMove* bestMove) {
+	if (table->entries == NULL)
+		return;
+	TTEntry* entry = &(table->entries[key & table->mask]);
+	entry->key = key;
+	entry->score = score;
+	entry->depth = depth;
+	entry->bound =
+			score <= alpha ? TT_BOUND_UPPER :
+			score >= beta ? TT_BOUND_LOWER : TT_BOUND_EXACT;
+	entry->bestFrom = entry->bestTo = NO_SQUARE;
+	if (bestMove != NULL) {
+		entry->bestFrom = chessGamePositionToSquare(bestMove->previousPosition);
+		entry->bestTo = chessGamePositionToSquare(bestMove->currentPosition);
+	}
+}
+
+/*
+ * Checks if the entry's score can be used as the result of a search of the
+ * given depth and alpha-beta window. Only entries of the same depth are used,
+ * so the table keeps the score of a search without it. It doesn't keep which
+ * of the moves with equal scores is chosen, as the hits change the order in
+ * which the ties are met.
+ */
+static bool isUsableEntry(TTEntry* entry, int depth, int alpha, int beta) {
+	if (entry == NULL || entry->depth != depth)
+		return false;
+	return entry->bound == TT_BOUND_EXACT
+			|| (entry->bound == TT_BOUND_LOWER && entry->score >= beta)
+			|| (entry->bound == TT_BOUND_UPPER && entry->score <= alpha);
+}
+
+
+/*
+ * Gets the board score, read from the game's running evaluation.
+ */
+static int scoringFunction(ChessGame* game) {
+	return chessGameGetEvaluation(game);
 }
 
 /*
@@ -120,106 +298,544 @@ bool initialized, int newScore, int idealScore) {
 	return true;
 }
 
+/*
+ * Static exchange evaluation: estimates the material the capture wins, if both
+ * players keep capturing on the target square with their least valuable
+ * piece, and may stop capturing when it doesn't pay off.
+ * Pieces behind a capturing bishop, rook or queen join the exchange.
+ */
+static int staticExchange(ChessBoard* board, ChessMove move) {
+	static const CHESS_PIECE_TYPE typesByScore[CHESS_N_PIECE_TYPES] = {
+			CHESS_PIECE_PAWN, CHESS_PIECE_KNIGHT, CHESS_PIECE_BISHOP,
+			CHESS_PIECE_ROOK, CHESS_PIECE_QUEEN, CHESS_PIECE_KING };
+	int gain[MAX_EXCHANGE_LENGTH];
+	int length = 0;
+	int to = chessGamePositionToSquare(move.currentPosition);
+	ChessPiece attacker = chessGameGetPieceByPosition(board,
+			move.previousPosition);
+	int player = attacker.player;
+	CHESS_PIECE_TYPE attackerType = attacker.type;
+	ChessBitboard attackerBit = chessBitboardSquare(
+			chessGamePositionToSquare(move.previousPosition));
+	ChessBitboard occupied = chessGameGetOccupied(board);
+	gain[0] = chessEvalGetPieceTypeScore(move.capturedPiece.type);
+
+	// Each gain is of the capturing player, given the opponent captures back
+	while (attackerBit && length + 1 < MAX_EXCHANGE_LENGTH) {
+		length++;
+		gain[length] = chessEvalGetPieceTypeScore(attackerType)
+				- gain[length - 1];
+		occupied ^= attackerBit;
+		player = chessGameGetOpponentByPlayer(player);
+		ChessBitboard attackers = chessMoveGetAttackers(board, to, occupied)
+				& occupied;
+		attackerBit = 0;
+		for (int i = 0; i < CHESS_N_PIECE_TYPES && !attackerBit; i++) {
+			ChessBitboard pieces = attackers
+					& board->pieces[player][typesByScore[i]];
+			if (pieces) {
+				attackerBit = pieces & (~pieces + 1);
+				attackerType = typesByScore[i];
+			}
+		}
+	}
+
+	// Each player may stop capturing instead of losing material
+	while (--length > 0)
+		if (-gain[length - 1] < gain[length])
+			gain[length - 1] = -gain[length];
+	return gain[0];
+}
+
+/*
+ * Gets the ordering score of a move in a node of the given depth, higher
+ * scores are searched first.
+ */
+static int getMoveOrderScore(SearchContext* context, ChessMove move, int depth,
+		int firstFrom, int firstTo) {
+	ChessBoard* board = &(context->game->gameBoard);
+	int from = chessGamePositionToSquare(move.previousPosition);
+	int to = chessGamePositionToSquare(move.currentPosition);
+	if (from == firstFrom && to == firstTo)
+		return ORDER_FIRST_MOVE;
+	if (move.capturedPiece.type == CHESS_PIECE_EMPTY) {
+		MoveSquares* killers = context->killers[depth];
+		if (killers[0].from == from && killers[0].to == to)
+			return ORDER_FIRST_KILLER;
+		if (killers[1].from == from && killers[1].to == to)
+			return ORDER_SECOND_KILLER;
+		return ORDER_QUIET_MOVE + context->history[from][to];
+	}
+	int mvvLva = chessEvalGetPieceTypeScore(move.capturedPiece.type)
+			* MVV_LVA_VICTIM_FACTOR
+			- chessEvalGetPieceTypeScore(
+					chessGameGetPieceByPosition(board, move.previousPosition).type);
+	return mvvLva
+			+ (staticExchange(board, move) >= 0 ?
+					ORDER_GOOD_CAPTURE : ORDER_BAD_CAPTURE);
+}
+
+/*
+ * Orders the moves of a node by their ordering scores. The root's best move
+ * from the previous iteration goes first, otherwise the best move found in the
+ * table. Moves with the same score keep their generation order.
+ */
+static void orderMoves(SearchContext* context, ChessMoveBuffer* moves,
+		TTEntry* entry, int depth) {
+	int scores[CHESS_MAX_MOVES];
+	int firstFrom = NO_SQUARE;
+	int firstTo = NO_SQUARE;
+	if (depth == 1 && context->hasPreviousMove) {
+		firstFrom = chessGamePositionToSquare(
+				context->previousMove.previousPosition);
+		firstTo = chessGamePositionToSquare(
+				context->previousMove.currentPosition);
+	} else if (entry != NULL) {
+		firstFrom = entry->bestFrom;
+		firstTo = entry->bestTo;
+	}
+
+	// Insertion sort, stable and fast enough for the number of moves
+	for (int k = 0; k < moves->size; k++) {
+		ChessMove move = moves->moves[k];
+		int score = getMoveOrderScore(context, move, depth, firstFrom,
+				firstTo);
+		int i = k;
+		for (; i > 0 && scores[i - 1] < score; i--) {
+			scores[i] = scores[i - 1];
+			moves->moves[i] = moves->moves[i - 1];
+		}
+		scores[i] = score;
+		moves->moves[i] = move;
+	}
+}
+
+/*
+ * Checks if the move is one of the killers of a node of the given depth.
+ */
+static bool isKillerMove(SearchContext* context, ChessMove move, int depth) {
+	int from = chessGamePositionToSquare(move.previousPosition);
+	int to = chessGamePositionToSquare(move.currentPosition);
+	for (int i = 0; i < NUM_OF_KILLERS; i++)
+		if (context->killers[depth][i].from == from
+				&& context->killers[depth][i].to == to)
+			return true;
+	return false;
+}
+
+/*
+ * Updates the killers and history of a quiet move which improved the score of
+ * a node of the given depth. Killers are kept only for moves causing a cutoff.
+ */
+static void updateQuietMove(SearchContext* context, ChessMove move, int depth,
+		bool isCutoff) {
+	int from = chessGamePositionToSquare(move.previousPosition);
+	int to = chessGamePositionToSquare(move.currentPosition);
+	int remainingDepth = context->maxDepth - depth + 1;
+	if (move.capturedPiece.type != CHESS_PIECE_EMPTY)
+		return;
+	if (isCutoff) {
+		MoveSquares* killers = context->killers[depth];
+		if (killers[0].from != from || killers[0].to != to) {
+			killers[1] = killers[0];
+			killers[0] = (MoveSquares ) { .from = from, .to = to };
+		}
+	}
+	context->history[from][to] += remainingDepth * remainingDepth;
+	if (context->history[from][to] > MAX_HISTORY_SCORE)
+		for (int i = 0; i < CHESS_N_SQUARES; i++)
+			for (int j = 0; j < CHESS_N_SQUARES; j++)
+				context->history[i][j] /= 2;
+}
+
+/*
+ * Resets the killers and history of the search.
+ */
+static void resetQuietMoves(SearchContext* context) {
+	for (int depth = 0; depth < MAX_SEARCH_DEPTH; depth++)
+		for (int i = 0; i < NUM_OF_KILLERS; i++)
+			context->killers[depth][i] = (MoveSquares ) { .from = NO_SQUARE,
+							.to = NO_SQUARE };
+	for (int i = 0; i < CHESS_N_SQUARES; i++)
+		for (int j = 0; j < CHESS_N_SQUARES; j++)
+			context->history[i][j] = 0;
+}
+
+/*
+ * Returns the current wall clock time in seconds.
+ */
+static double getTime() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/*
+ * Checks the time limit once every TIME_CHECK_NODES nodes.
+ * @return
+ * true if the search should stop.
+ */
+static bool isSearchStopped(SearchContext* context) {
+	if (!context->isTimeUp && context->hasDeadline
+			&& ++context->nodes % TIME_CHECK_NODES == 0)
+		context->isTimeUp = getTime() >= context->deadline;
+	return context->isTimeUp;
+}
+
+/*
+ * The quiescence search, continues the search beyond the max depth until the
+ * position is quiet so the board isn't scored in the middle of an exchange.
+ * Only captures are searched, and the player may stand pat on the board score
+ * instead. A player in check searches all of its moves and may not stand pat.
+ * Captures which can't reach the bound even with DELTA_MARGIN are skipped.
+ */
+static int quiescence(SearchContext* context, int depth, int alpha, int beta) {
+	ChessGame* game = context->game;
+	int player = game->currentPlayer;
+	bool isCheck = game->isCheck;
+	int standPat = scoringFunction(game);
+	int idealScore = player == CHESS_WHITE_PLAYER ? INT_MIN : INT_MAX;
+	bool hasLegalMove = false;
+	if (isSearchStopped(context))
+		return 0;
+	if (depth >= MAX_SEARCH_DEPTH)
+		return standPat;
+
+	if (!isCheck) {
+		idealScore = standPat;
+		if (player == CHESS_WHITE_PLAYER && standPat > alpha)
+			alpha = standPat;
+		else if (player == CHESS_BLACK_PLAYER && standPat < beta)
+			beta = standPat;
+		if (beta <= alpha)
+			return standPat;
+	}
+
+	ChessMoveBuffer moves;
+	moves.size = 0;
+	chessGameGeneratePseudoLegalMoves(game, &moves);
+	orderMoves(context, &moves, NULL, depth);
+	for (int k = 0; k < moves.size; k++) {
+		ChessMove move = moves.moves[k];
+		if (!isCheck) {
+			if (move.capturedPiece.type == CHESS_PIECE_EMPTY)
+				continue;
+			int maxGain = chessEvalGetPieceTypeScore(move.capturedPiece.type)
+					+ DELTA_MARGIN;
+			if (player == CHESS_WHITE_PLAYER ?
+					standPat + maxGain <= alpha : standPat - maxGain >= beta)
+				continue;
+		}
+		if (chessGameSetPseudoLegalMove(game, move) != CHESS_GAME_SUCCESS)
+			continue;
+		hasLegalMove = true;
+		int score = quiescence(context, depth + 1, alpha, beta);
+		chessGameUndoMove(game);
+		if (context->isTimeUp)
+			return 0;
+
+		if (isBetterScore(score, idealScore, player)) {
+			idealScore = score;
+			if (player == CHESS_WHITE_PLAYER && score > alpha)
+				alpha = score;
+			else if (player == CHESS_BLACK_PLAYER && score < beta)
+				beta = score;
+			if (beta <= alpha)
+				break;
+		}
+	}
+	if (isCheck && !hasLegalMove)
+		return player == CHESS_WHITE_PLAYER ?
+				BLACK_CHECKMATE_SCORE : WHITE_CHECKMATE_SCORE;
+	return idealScore;
+}
+
 /*
  * Checks the state before executing another round of the recursion.
+ * msg is the node's state, computed once by MinimaxRec.
  * @return
- * 1000 - white player wins.
- * -1000 - black player wins.
+ * WHITE_CHECKMATE_SCORE - white player wins.
+ * BLACK_CHECKMATE_SCORE - black player wins.
  * 0 - the game ends in a draw.
- * the board score - if depth > maxDepth.
+ * the quiescence search score - if depth > maxDepth.
  */
-static int MinimaxValidation(int depth, int maxDepth, ChessGame* game,
-		int player) {
-	CHESS_GAME_MESSAGE msg = chessGameGetCurrentState(game);
+static int MinimaxValidation(SearchContext* context, CHESS_GAME_MESSAGE msg,
+		int depth, int alpha, int beta) {
+	ChessGame* game = context->game;
 	if (msg == CHESS_GAME_CHECKMATE)
-		return player == CHESS_WHITE_PLAYER ?
+		return game->currentPlayer == CHESS_WHITE_PLAYER ?
 		BLACK_CHECKMATE_SCORE :
-												WHITE_CHECKMATE_SCORE;
+															WHITE_CHECKMATE_SCORE;
 	else if (msg == CHESS_GAME_DRAW)
 		return DRAW_SCORE;
-	else if (depth > maxDepth)
-		return scoringFunction(&(game->gameBoard));
+	else if (depth > context->maxDepth)
+		return quiescence(context, depth, alpha, beta);
 	return INT_MAX;
 }
 
+static int MinimaxRec(TreeNode* parent, SearchContext* context, int depth,
+		int alpha, int beta);
+
+/*
+ * Checks if the player has pieces other than pawns and king. Without them,
+ * zugzwang positions are common and passing the turn isn't a safe guess.
+ */
+static bool hasMajorOrMinorPiece(ChessBoard* board, int player) {
+	return (board->occupied[player]
+			& ~(board->pieces[player][CHESS_PIECE_PAWN]
+					| board->pieces[player][CHESS_PIECE_KING])) != 0;
+}
+
+/*
+ * Null move pruning: passes the turn and searches the opponent's moves with a
+ * reduced depth and a null window at the player's bound.
+ * @return
+ * true if the player still fails high, so the node can be cut off.
+ */
+static bool isNullMoveCutoff(SearchContext* context, int depth, int alpha,
+		int beta) {
+	ChessGame* game = context->game;
+	int player = game->currentPlayer;
+	TreeNode node;
+	int score;
+	chessGameSetNullMove(game);
+	context->isAfterNullMove = true;
+	if (player == CHESS_WHITE_PLAYER)
+		score = MinimaxRec(&node, context, depth + 1 + NULL_MOVE_REDUCTION,
+				beta - 1, beta);
+	else
+		score = MinimaxRec(&node, context, depth + 1 + NULL_MOVE_REDUCTION,
+				alpha, alpha + 1);
+	chessGameUndoNullMove(game);
+	if (context->isTimeUp)
+		return false;
+	return player == CHESS_WHITE_PLAYER ? score >= beta : score <= alpha;
+}
+
 /*
  * The recursive algorithm, once called updates the parent node with the best move and returns the score of the said
  * move.
  */
-static int MinimaxRec(TreeNode* parent, ChessGame* game, int maxDepth,
-		int depth, int alpha, int beta) {
+static int MinimaxRec(TreeNode* parent, SearchContext* context, int depth,
+		int alpha, int beta) {
+	ChessGame* game = context->game;
+	int maxDepth = context->maxDepth;
 	int player = game->currentPlayer;
+	int alphaOrig = alpha;
+	int betaOrig = beta;
+	uint64_t key = chessGameGetHash(game);
+	TTEntry* entry = NULL;
+	bool isAfterNullMove = context->isAfterNullMove;
+	context->isAfterNullMove = false;
+	if (isSearchStopped(context))
+		return 0;
+
+	//Positions searched before to enough depth don't need another search, except the root which needs a move.
+	if (depth <= maxDepth) {
+		entry = transpositionTableProbe(&(context->table), key);
+		if (depth > 1
+				&& isUsableEntry(entry, maxDepth - depth + 1, alpha, beta))
+			return entry->score;
+	}
+
 	//Checking whether before entering the recursive part, we've already reached max depth, checkmate or draw.
+	//The state is computed once per node, it reads game->isCheck which is set when a move is played.
+	CHESS_GAME_MESSAGE state = chessGameGetCurrentState(game);
 	if (depth > maxDepth
-			|| (chessGameGetCurrentState(game) != CHESS_GAME_NONE
-					&& chessGameGetCurrentState(game) != CHESS_GAME_CHECK))
-		return MinimaxValidation(depth, maxDepth, game, player);
+			|| (state != CHESS_GAME_NONE && state != CHESS_GAME_CHECK))
+		return MinimaxValidation(context, state, depth, alpha, beta);
+
+	//Null move pruning, not done twice in a row, in check or with only pawns, where passing may be the best move.
+	bool isCheck = game->isCheck;
+	int remainingDepth = maxDepth - depth + 1;
+	int staticScore = scoringFunction(game);
+	if (depth > 1 && !isAfterNullMove && !isCheck
+			&& remainingDepth >= NULL_MOVE_MIN_DEPTH
+			&& hasMajorOrMinorPiece(&(game->gameBoard), player)) {
+		bool isAboveBound =
+				player == CHESS_WHITE_PLAYER ?
+						beta != INT_MAX && staticScore >= beta :
+						alpha != INT_MIN && staticScore <= alpha;
+		if (isAboveBound && isNullMoveCutoff(context, depth, alpha, beta))
+			return player == CHESS_WHITE_PLAYER ? beta : alpha;
+		if (context->isTimeUp)
+			return 0;
+	}
+
+	//Razoring, a node far below the bound near the max depth is only searched for captures, and only if they
+	//can bring it back to the bound it gets a full search.
+	if (depth > 1 && !isCheck && remainingDepth <= RAZOR_MAX_DEPTH) {
+		int margin = RAZOR_MARGIN * remainingDepth;
+		int score;
+		if (player == CHESS_WHITE_PLAYER && alpha != INT_MIN
+				&& staticScore + margin <= alpha) {
+			score = quiescence(context, depth, alpha, alpha + 1);
+			if (context->isTimeUp || score <= alpha)
+				return score;
+		} else if (player == CHESS_BLACK_PLAYER && beta != INT_MAX
+				&& staticScore - margin >= beta) {
+			score = quiescence(context, depth, beta - 1, beta);
+			if (context->isTimeUp || score >= beta)
+				return score;
+		}
+	}
+	bool isFutileNode = depth > 1 && !isCheck
+			&& remainingDepth <= FUTILITY_MAX_DEPTH;
+	int futilityMargin = FUTILITY_MARGIN * remainingDepth;
 
 	//initializing the node score to be the "worst" score for the player.
 	int idealScore = player == CHESS_WHITE_PLAYER ? INT_MIN : INT_MAX;
 	bool initialized = false;
+	int numOfSearchedMoves = 0;
 
-	//Going through all of the current player's pieces.
-	for (int i = 0; i < CHESS_N_ROWS; i++) {
-		for (int j = 0; j < CHESS_N_COLUMNS; j++) {
-			ChessPiece piece = game->gameBoard.position[i][j];
-			//skip if not the player's piece
-			if (piece.player != player)
-				continue;
-			ChessPiecePosition position = { .row = i, .column = j };
-			ArrayList* moves = chessGameGetMoves(game, position);
+	//Going through all of the current player's moves.
+	//Moves which threaten the player's king are rejected only once played.
+	ChessMoveBuffer moves;
+	moves.size = 0;
+	chessGameGeneratePseudoLegalMoves(game, &moves);
+	orderMoves(context, &moves, entry, depth);
+	ChessMove bestMove = moves.moves[0];
+	for (int k = 0; k < moves.size; k++) {
+		TreeNode node;
+		node.move = moves.moves[k];
 
-			if (moves == NULL) {
-				return idealScore;
-			}
-			//going through all moves of a specific piece
-			for (int k = 0; k < moves->actualSize; k++) {
-				ChessMove move = arrayListGetAt(moves, k);
-				TreeNode node;
-				node.move = move;
-
-				chessGameSetMove(game, position, node.move.currentPosition);
-				node.score = MinimaxRec(&node, game, maxDepth, depth + 1, alpha,
-						beta);
-				chessGameUndoMove(game);
-
-				//Checking whether this move is a better move than the last one chosen.
-				if (isBetterScore(node.score, idealScore, player)
-						|| isBetterLocation(node.move, parent->bestMove,
-								initialized, node.score, idealScore)) {
-					initialized = true;
-					idealScore = node.score;
-					parent->bestMove = node.move; //only relevant if parent is root
-
-					//Pruning
-					if (player && isBetterScore(idealScore, alpha, player))
-						alpha = idealScore;
-					else if (!player && isBetterScore(idealScore, beta, player))
-						beta = idealScore;
-					if (beta <= alpha) {
-						arrayListDestroy(moves);
-						return idealScore;
-					}
-				}
-			}
-			arrayListDestroy(moves);
+		if (chessGameSetPseudoLegalMove(game, node.move) != CHESS_GAME_SUCCESS)
+			continue;
+
+		//Futility pruning, once a move was searched quiet moves which can't reach the bound are skipped.
+		if (isFutileNode && initialized && !game->isCheck
+				&& node.move.capturedPiece.type == CHESS_PIECE_EMPTY
+				&& (player == CHESS_WHITE_PLAYER ?
+						staticScore + futilityMargin <= alpha :
+						staticScore - futilityMargin >= beta)) {
+			chessGameUndoMove(game);
+			continue;
+		}
+		numOfSearchedMoves++;
+
+		//Principal variation search. The moves after the first are checked with a null window to fail
+		//against the current bound, and searched again with the full window only if they don't.
+		//Late quiet moves are checked with a reduced depth first, unless they check or escape a check.
+		if (!initialized)
+			node.score = MinimaxRec(&node, context, depth + 1, alpha, beta);
+		else {
+			int scoutAlpha = player == CHESS_WHITE_PLAYER ? alpha : beta - 1;
+			int scoutBeta = player == CHESS_WHITE_PLAYER ? alpha + 1 : beta;
+			bool isReduced = depth > 1 && remainingDepth >= LMR_MIN_DEPTH
+					&& numOfSearchedMoves > LMR_MIN_MOVES && !isCheck
+					&& !game->isCheck
+					&& node.move.capturedPiece.type == CHESS_PIECE_EMPTY
+					&& !isKillerMove(context, node.move, depth);
+			node.score = MinimaxRec(&node, context,
+					depth + 1 + (isReduced ? LMR_REDUCTION : 0), scoutAlpha,
+					scoutBeta);
+			if (isReduced && !context->isTimeUp
+					&& (player == CHESS_WHITE_PLAYER ?
+							node.score > scoutAlpha : node.score < scoutBeta))
+				node.score = MinimaxRec(&node, context, depth + 1, scoutAlpha,
+						scoutBeta);
+			if (!context->isTimeUp && node.score > alpha && node.score < beta
+					&& (scoutAlpha != alpha || scoutBeta != beta))
+				node.score = MinimaxRec(&node, context, depth + 1, alpha, beta);
+		}
+		chessGameUndoMove(game);
+		if (context->isTimeUp)
+			return 0;
+
+		//Checking whether this move is a better move than the last one chosen.
+		if (isBetterScore(node.score, idealScore, player)
+				|| isBetterLocation(node.move, parent->bestMove, initialized,
+						node.score, idealScore)) {
+			initialized = true;
+			idealScore = node.score;
+			bestMove = node.move;
+			parent->bestMove = node.move; //only relevant if parent is root
+
+			//Pruning. The root keeps moves scoring the same as the best move inside the window,
+			//so their scores are exact and isBetterLocation only breaks real ties.
+			int bound = depth > 1 ? idealScore :
+						player ? idealScore - 1 : idealScore + 1;
+			bool isImproved = false;
+			if (player && isBetterScore(bound, alpha, player))
+				alpha = bound, isImproved = true;
+			else if (!player && isBetterScore(bound, beta, player))
+				beta = bound, isImproved = true;
+			if (isImproved)
+				updateQuietMove(context, node.move, depth, beta <= alpha);
+			if (beta <= alpha)
+				break;
 		}
 	}
+	transpositionTableStore(&(context->table), key, maxDepth - depth + 1,
+			idealScore, alphaOrig, betaOrig, &bestMove);
 	return idealScore;
 }
 
 /*
  * Returns a tree node that holds the computer's ideal move for the relevant difficulty level.
+ * The depths are searched one at a time, each starting from the previous depth's best move and using
+ * the table filled by the previous depths. Each depth is first searched with a window around the
+ * previous depth's score, and searched again with a wider window if its score falls outside.
+ * The search stops at the settings' time limit, and uses a table of the settings' size.
  */
 ChessMove chessGameMinimax(GameSettings* settings) {
 	TreeNode root;
+	SearchContext context;
+	double start = getTime();
+	memset(&root, 0, sizeof(TreeNode)); //The returned move if the search fails
 	ChessGame* copiedGame = chessGameCopyEmptyHistory(settings->chessGame,
-			settings->maxDepth);
+			MAX_SEARCH_DEPTH);
 	if (copiedGame == NULL) //Failure to copy game
 		return root.move;
+	if (!transpositionTableCreate(&(context.table),
+			settings->searchTableSizeMB)) {
+		chessGameDestroy(copiedGame);
+		return root.move;
+	}
+	context.game = copiedGame;
+	context.hasPreviousMove = false;
+	resetQuietMoves(&context);
+	context.isAfterNullMove = false;
+	context.hasDeadline = false;
+	context.isTimeUp = false;
+	context.nodes = 0;
+	root.score = DRAW_SCORE;
 
-	root.score = MinimaxRec(&root, copiedGame, settings->maxDepth, 1, INT_MIN,
-	INT_MAX);
+	//Searching each depth up to the max depth, the first depth is always completed.
+	for (int depth = 1; depth <= (int) settings->maxDepth; depth++) {
+		TreeNode node;
+		int window = ASPIRATION_WINDOW;
+		int alpha = INT_MIN;
+		int beta = INT_MAX;
+		if (depth > 1 && root.score > BLACK_CHECKMATE_SCORE
+				&& root.score < WHITE_CHECKMATE_SCORE) {
+			alpha = root.score - window;
+			beta = root.score + window;
+		}
+		context.maxDepth = depth;
+		while (true) {
+			node.score = MinimaxRec(&node, &context, 1, alpha, beta);
+			if (context.isTimeUp || (node.score > alpha && node.score < beta))
+				break;
+			window *= 2;
+			if (node.score <= alpha)
+				alpha = window < WHITE_CHECKMATE_SCORE ?
+						root.score - window : INT_MIN;
+			else
+				beta = window < WHITE_CHECKMATE_SCORE ?
+						root.score + window : INT_MAX;
+		}
+		if (context.isTimeUp)
+			break;
+		root = node;
+		context.hasPreviousMove = true;
+		context.previousMove = node.bestMove;
+		if (depth == 1 && settings->searchTimeLimitMS > 0) {
+			context.hasDeadline = true;
+			context.deadline = start + settings->searchTimeLimitMS / 1000.0;
+		}
+	}
+	free(context.table.entries);
 	chessGameDestroy(copiedGame);
 	return root.bestMove;
 }
@@ -5,18 +5,11 @@
 #include "ChessGame.h"
 #include "GameSettings.h"
 
-/*
- * Definitions for pieces' scores
- */
-#define PAWN_SCORE 1
-#define KNIGHT_SCORE 3
-#define BISHOP_SCORE 3
-#define ROOK_SCORE 5
-#define QUEEN_SCORE 9
-#define KING_SCORE 100
-
 /*
  * Returns a ChessMove that is the computer's ideal move for the relevant difficulty level.
+ * The search deepens one depth at a time up to the difficulty level, and once the settings'
+ * time limit passes returns the best move of the deepest completed depth. The transposition
+ * table of the settings' size is allocated for each search, a size of 0 disables it.
  */
 ChessMove chessGameMinimax(GameSettings* settings);
 
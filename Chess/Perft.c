@@ -0,0 +1,270 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "ChessErrorHandler.h"
+#include "Perft.h"
+
+/**
+ * Definitions for the hash table of counted positions.
+ * The table is shared by the threads without locks. Each of an entry's words is
+ * read and written atomically, and the entry keeps the position's key xor-ed
+ * with its data, so an entry torn by two threads writing at once fails to match.
+ */
+#define PERFT_BYTES_IN_MB (1024 * 1024)
+#define PERFT_DEPTH_BITS 8
+#define PERFT_DEPTH_MASK ((1ULL << PERFT_DEPTH_BITS) - 1)
+
+/**
+ * Output format
+ */
+#define PERFT_MOVE_FORMAT "<%d,%c> -> <%d,%c>: %llu\n"
+#define PERFT_SUMMARY_FORMAT "\nNodes: %llu\nTime: %.3fs\nNodes/sec: %.0f\n"
+
+typedef struct perft_entry_t {
+	uint64_t check;
+	uint64_t data;
+} PerftEntry;
+
+typedef struct perft_table_t {
+	PerftEntry* entries;
+	uint64_t mask;
+} PerftTable;
+
+/**
+ * The work of a single thread in perftDivide. The thread counts the moves from
+ * index first, skipping numOfThreads moves each time.
+ */
+typedef struct perft_thread_data_t {
+	ChessGame* game;
+	ChessMoveBuffer* moves;
+	unsigned long long* counts;
+	PerftTable* table;
+	int depth;
+	int first;
+	int numOfThreads;
+} PerftThreadData;
+
+/**
+ * Creates a table with the largest power of 2 entries fitting in sizeMB.
+ * Returns false on allocation failure.
+ */
+static bool perftTableCreate(PerftTable* table, int sizeMB) {
+	uint64_t numOfEntries = 1;
+	uint64_t maxEntries = (uint64_t) sizeMB * PERFT_BYTES_IN_MB
+			/ sizeof(PerftEntry);
+	table->entries = NULL;
+	table->mask = 0;
+	if (sizeMB <= 0)
+		return true;
+	while (numOfEntries * 2 <= maxEntries)
+		numOfEntries *= 2;
+	table->entries = calloc(numOfEntries, sizeof(PerftEntry));
+	if (table->entries == NULL) {
+		hadMemoryFailure();
+		return false;
+	}
+	table->mask = numOfEntries - 1;
+	return true;
+}
+
+/**
+ * Looks for the count of the position's tree of the given depth.
+ * Returns true and updates count if found.
+ */
+static bool perftTableGet(PerftTable* table, uint64_t key, int depth,
+		unsigned long long* count) {
+	if (table == NULL || table->entries == NULL)
+		return false;
+	PerftEntry* entry = &(table->entries[key & table->mask]);
+	uint64_t check = __atomic_load_n(&(entry->check), __ATOMIC_RELAXED);
+	uint64_t data = __atomic_load_n(&(entry->data), __ATOMIC_RELAXED);
+	if ((check ^ data) != key || (data & PERFT_DEPTH_MASK) != (uint64_t) depth)
+		return false;
+	*count = data >> PERFT_DEPTH_BITS;
+	return true;
+}
+
+/**
+ * Stores the count of the position's tree of the given depth, replacing the
+ * entry in its place.
+ */
+static void perftTablePut(PerftTable* table, uint64_t key, int depth,
+		unsigned long long count) {
+	if (table == NULL || table->entries == NULL)
+		return;
+	PerftEntry* entry = &(table->entries[key & table->mask]);
+	uint64_t data = ((uint64_t) count << PERFT_DEPTH_BITS) | (uint64_t) depth;
+	__atomic_store_n(&(entry->check), key ^ data, __ATOMIC_RELAXED);
+	__atomic_store_n(&(entry->data), data, __ATOMIC_RELAXED);
+}
+
+/**
+ * Counts the leaves of the tree of the given depth, using the table if given.
+ * The last level isn't played, the number of moves is counted instead.
+ */
+static unsigned long long perftCountRec(ChessGame* game, int depth,
+		PerftTable* table) {
+	unsigned long long count = 0;
+	uint64_t key = 0;
+	if (depth == 0)
+		return 1;
+	if (depth > 1 && table != NULL && table->entries != NULL) {
+		key = chessGameGetHash(game);
+		if (perftTableGet(table, key, depth, &count))
+			return count;
+	}
+
+	ChessMoveBuffer moves;
+	moves.size = 0;
+	chessGameGenerateAllMoves(game, &moves);
+	if (depth == 1)
+		return moves.size;
+	for (int i = 0; i < moves.size; i++) {
+		chessGameSetMove(game, moves.moves[i].previousPosition,
+				moves.moves[i].currentPosition);
+		count += perftCountRec(game, depth - 1, table);
+		chessGameUndoMove(game);
+	}
+	perftTablePut(table, key, depth, count);
+	return count;
+}
+
+/**
+ * Counts the leaves of the legal moves tree of the game, up to depth moves.
+ * The game is restored to its original state when done.
+ *
+ * @param game - The source game. Assumes not NULL, with history size of at
+ *               least depth.
+ * @param depth - The depth of the tree. Assumes not negative.
+ *
+ * @return
+ * The number of leaves, 1 if depth is 0.
+ */
+unsigned long long perftCount(ChessGame* game, int depth) {
+	return perftCountRec(game, depth, NULL);
+}
+
+/**
+ * The entry point of a perftDivide thread, arg is its PerftThreadData.
+ * Counts the trees under the thread's share of the moves into counts.
+ */
+static void* perftThread(void* arg) {
+	PerftThreadData* data = arg;
+	for (int i = data->first; i < data->moves->size; i += data->numOfThreads) {
+		ChessMove move = data->moves->moves[i];
+		chessGameSetMove(data->game, move.previousPosition,
+				move.currentPosition);
+		data->counts[i] = perftCountRec(data->game, data->depth - 1,
+				data->table);
+		chessGameUndoMove(data->game);
+	}
+	return NULL;
+}
+
+/**
+ * Returns the current wall clock time in seconds.
+ */
+static double getTime() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Prints the counts of each move and the summary.
+ */
+static void printDivide(FILE* out, ChessMoveBuffer* moves,
+		unsigned long long* counts, double seconds) {
+	unsigned long long total = 0;
+	for (int i = 0; i < moves->size; i++) {
+		ChessMove move = moves->moves[i];
+		fprintf(out, PERFT_MOVE_FORMAT, move.previousPosition.row + 1,
+				'A' + move.previousPosition.column,
+				move.currentPosition.row + 1, 'A' + move.currentPosition.column,
+				counts[i]);
+		total += counts[i];
+	}
+	fprintf(out, PERFT_SUMMARY_FORMAT, total, seconds,
+			seconds > 0 ? total / seconds : 0);
+}
+
+/**
+ * Counts the leaves of the legal moves tree of the game, up to depth moves.
+ * Prints the count under each of the current player's moves, followed by the
+ * total count, elapsed time and nodes per second.
+ *
+ * @param game - The source game. It is not changed.
+ * @param depth - The depth of the tree, at least 1.
+ * @param numOfThreads - The number of threads sharing the moves, between 1
+ *                       and PERFT_MAX_THREADS. The moves of a thread which
+ *                       can't be started are counted by the calling thread.
+ * @param tableSizeMB - The size of the hash table of counted positions in
+ *                      megabytes, shared by all threads. 0 for no table.
+ * @param out - The output file.
+ *
+ * @return
+ * PERFT_INVALID_ARGUMENT - if one of the arguments is invalid.
+ * PERFT_MEMORY_FAILURE - if a memory allocation failure occurred.
+ * PERFT_SUCCESS - otherwise.
+ */
+PERFT_MESSAGE perftDivide(ChessGame* game, int depth, int numOfThreads,
+		int tableSizeMB, FILE* out) {
+	if (game == NULL || out == NULL || depth < 1 || numOfThreads < 1
+			|| numOfThreads > PERFT_MAX_THREADS || tableSizeMB < 0)
+		return PERFT_INVALID_ARGUMENT;
+
+	PerftTable table;
+	if (!perftTableCreate(&table, tableSizeMB))
+		return PERFT_MEMORY_FAILURE;
+	ChessMoveBuffer moves;
+	unsigned long long counts[CHESS_MAX_MOVES];
+	PerftThreadData data[PERFT_MAX_THREADS];
+	pthread_t threads[PERFT_MAX_THREADS];
+	PERFT_MESSAGE res = PERFT_SUCCESS;
+	int numOfCopies = 0;
+	moves.size = 0;
+	chessGameGenerateAllMoves(game, &moves);
+
+	// Every thread plays on its own copy of the game
+	for (; numOfCopies < numOfThreads; numOfCopies++) {
+		data[numOfCopies] = (PerftThreadData ) { .game =
+						chessGameCopyEmptyHistory(game, depth), .moves =
+						&moves, .counts = counts, .table = &table, .depth =
+						depth, .first = numOfCopies, .numOfThreads =
+						numOfThreads };
+		if (data[numOfCopies].game == NULL) {
+			res = PERFT_MEMORY_FAILURE;
+			break;
+		}
+	}
+
+	if (res == PERFT_SUCCESS) {
+		double start = getTime();
+		int numOfStarted = 1;
+		for (int i = 0; i < moves.size; i++)
+			counts[i] = 0;
+		for (; numOfStarted < numOfThreads; numOfStarted++)
+			if (pthread_create(&threads[numOfStarted], NULL, perftThread,
+					&data[numOfStarted]) != 0)
+				break;
+		// Moves of threads which failed to start are counted by this thread
+		for (int i = 0; i < moves.size; i++)
+			if (i % numOfThreads == 0 || i % numOfThreads >= numOfStarted) {
+				ChessMove move = moves.moves[i];
+				chessGameSetMove(data[0].game, move.previousPosition,
+						move.currentPosition);
+				counts[i] = perftCountRec(data[0].game, depth - 1, &table);
+				chessGameUndoMove(data[0].game);
+			}
+		for (int i = 1; i < numOfStarted; i++)
+			pthread_join(threads[i], NULL);
+		printDivide(out, &moves, counts, getTime() - start);
+	}
+
+	for (int i = 0; i < numOfCopies; i++)
+		chessGameDestroy(data[i].game);
+	free(table.entries);
+	return res;
+}
@@ -0,0 +1,68 @@
+#ifndef PERFT_H_
+#define PERFT_H_
+
+#include <stdio.h>
+#include "ChessGame.h"
+
+/**
+ * Perft Summary:
+ *
+ * Counts the leaves of the legal moves tree of a game up to a given depth.
+ * Used as a correctness and throughput benchmark of the move generation,
+ * since the counts of known positions are well known.
+ *
+ * perftCount  - Counts the leaves of the legal moves tree
+ * perftDivide - Counts and prints the leaves under each of the current moves
+ *
+ */
+
+/**
+ * Maximum number of threads for perftDivide
+ */
+#define PERFT_MAX_THREADS 64
+
+/**
+ * Type used for returning error codes from perft functions
+ */
+typedef enum perft_message_t {
+	PERFT_SUCCESS,
+	PERFT_INVALID_ARGUMENT,
+	PERFT_MEMORY_FAILURE,
+} PERFT_MESSAGE;
+
+/**
+ * Counts the leaves of the legal moves tree of the game, up to depth moves.
+ * The game is restored to its original state when done.
+ *
+ * @param game - The source game. Assumes not NULL, with history size of at
+ *               least depth.
+ * @param depth - The depth of the tree. Assumes not negative.
+ *
+ * @return
+ * The number of leaves, 1 if depth is 0.
+ */
+unsigned long long perftCount(ChessGame* game, int depth);
+
+/**
+ * Counts the leaves of the legal moves tree of the game, up to depth moves.
+ * Prints the count under each of the current player's moves, followed by the
+ * total count, elapsed time and nodes per second.
+ *
+ * @param game - The source game. It is not changed.
+ * @param depth - The depth of the tree, at least 1.
+ * @param numOfThreads - The number of threads sharing the moves, between 1
+ *                       and PERFT_MAX_THREADS. The moves of a thread which
+ *                       can't be started are counted by the calling thread.
+ * @param tableSizeMB - The size of the hash table of counted positions in
+ *                      megabytes, shared by all threads. 0 for no table.
+ * @param out - The output file.
+ *
+ * @return
+ * PERFT_INVALID_ARGUMENT - if one of the arguments is invalid.
+ * PERFT_MEMORY_FAILURE - if a memory allocation failure occurred.
+ * PERFT_SUCCESS - otherwise.
+ */
+PERFT_MESSAGE perftDivide(ChessGame* game, int depth, int numOfThreads,
+		int tableSizeMB, FILE* out);
+
+#endif /* PERFT_H_ */
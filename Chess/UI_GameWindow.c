@@ -23,14 +23,7 @@
 static const int OTHER_BUTTONS_NUM = 6;
 
 static int getNumberOfPieces(ChessGame* game) {
-	int count = 0;
-	for (int i = 0; i < CHESS_N_ROWS; i++) {
-		for (int j = 0; j < CHESS_N_COLUMNS; j++) {
-			if (game->gameBoard.position[i][j].type != CHESS_PIECE_EMPTY)
-				count++;
-		}
-	}
-	return count;
+	return chessBitboardCount(chessGameGetOccupied(&(game->gameBoard)));
 }
 
 static int getNumberOfWidgets(GameWindowData* data) {
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
 #include "UI_Window.h"
 #include "UI_Auxiliary.h"
 #include "UI_WindowController.h"
@@ -12,12 +13,18 @@
 #include "ChessErrorHandler.h"
 #include "MainAux.h"
 #include "GameSettings.h"
+#include "LoadGame.h"
+#include "Perft.h"
 
 /*
  * Arguments
  */
 #define CHESS_FLAG_MAIN_CONSOLE "-c"
 #define CHESS_FLAG_MAIN_GUI "-g"
+#define CHESS_FLAG_MAIN_PERFT "-p"
+#define CHESS_FLAG_PERFT_FILE "-f"
+#define CHESS_FLAG_PERFT_THREADS "-t"
+#define CHESS_FLAG_PERFT_TABLE "-h"
 
 /*
  * Printable strs
@@ -26,6 +33,8 @@
 #define INVALID_FIRST_ARGUMENT_ERR "ERROR: First argument must be %s or %s"
 #define SDL_INIT_ERR "ERROR: unable to init SDL: %s\n"
 #define ENTER_MOVE_STR "Enter your move (%s player):\n"
+#define PERFT_USAGE_ERR "ERROR: Usage: %s <depth> [%s <file>] [%s <threads>] [%s <table size MB>]\n"
+#define PERFT_LOAD_ERR "ERROR: File doesn't exist or cannot be opened\n"
 
 static int guiMain() {
 	if (SDL_Init(SDL_INIT_VIDEO) < 0) { //SDL2 INIT
@@ -124,9 +133,75 @@ static int consoleMain() {
 	return EXIT_SUCCESS;
 }
 
+/*
+ * Parses a non negative number argument. Returns -1 if invalid.
+ */
+static int parsePerftNumber(char* arg) {
+	char* end;
+	long num = strtol(arg, &end, 10);
+	if (*arg == '\0' || *end != '\0' || num < 0 || num > INT_MAX)
+		return -1;
+	return (int) num;
+}
+
+static void printPerftUsage() {
+	printf(PERFT_USAGE_ERR, CHESS_FLAG_MAIN_PERFT, CHESS_FLAG_PERFT_FILE,
+	CHESS_FLAG_PERFT_THREADS, CHESS_FLAG_PERFT_TABLE);
+}
+
+static int perftMain(int argc, char** argv) {
+	int depth = argc > 2 ? parsePerftNumber(argv[2]) : -1;
+	int numOfThreads = 1;
+	int tableSizeMB = 0;
+	char* fileName = NULL;
+	bool isValid = depth > 0;
+	for (int i = 3; isValid && i < argc; i += 2) {
+		if (i + 1 >= argc)
+			isValid = false;
+		else if (!strcmp(argv[i], CHESS_FLAG_PERFT_FILE))
+			fileName = argv[i + 1];
+		else if (!strcmp(argv[i], CHESS_FLAG_PERFT_THREADS))
+			isValid = (numOfThreads = parsePerftNumber(argv[i + 1])) > 0;
+		else if (!strcmp(argv[i], CHESS_FLAG_PERFT_TABLE))
+			isValid = (tableSizeMB = parsePerftNumber(argv[i + 1])) >= 0;
+		else
+			isValid = false;
+	}
+	if (!isValid) {
+		printPerftUsage();
+		return EXIT_FAILURE;
+	}
+
+	GameSettings* settings = gameSettingsCreate();
+	if (settings == NULL || getHadMemoryFailure()) {
+		printCriticalError();
+		return EXIT_FAILURE;
+	}
+	if (fileName != NULL
+			&& gameSettingsLoad(settings, fileName)
+					!= GAME_SETTINGS_LOAD_FILE_SUCCESS) {
+		printf(PERFT_LOAD_ERR);
+		gameSettingsDestroy(settings);
+		return EXIT_FAILURE;
+	}
+	PERFT_MESSAGE msg = perftDivide(settings->chessGame, depth, numOfThreads,
+			tableSizeMB, stdout);
+	gameSettingsDestroy(settings);
+	if (msg == PERFT_INVALID_ARGUMENT) {
+		printPerftUsage();
+		return EXIT_FAILURE;
+	} else if (msg == PERFT_MEMORY_FAILURE) {
+		printCriticalError();
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
 int main(int argc, char** argv) {
 	int res;
-	if (argc > 2) {
+	if (argc > 1 && !strcmp(argv[1], CHESS_FLAG_MAIN_PERFT)) {
+		res = perftMain(argc, argv);
+	} else if (argc > 2) {
 		printf(INVALID_NUM_ARGUMENTS_ERR);
 		res = EXIT_FAILURE;
 	} else if (argc == 2) {